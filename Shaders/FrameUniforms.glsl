@@ -0,0 +1,22 @@
+// Per-frame uniform blocks, filled once per frame by the renderer. Shader
+// replaces `#include "FrameUniforms.glsl"` with this file; the layouts must
+// match FrameUniforms in UniformBuffer.h.
+
+struct Light {
+    vec3 direction;
+    vec3 ambient;
+    vec3 diffuse;
+};
+
+layout(std140) uniform Camera {
+    mat4 uView;
+    mat4 uProjection;
+};
+
+layout(std140) uniform Shading {
+    Light light;
+    vec3 wireframeColor;
+    float wireframeWidth;
+    vec3 fillColor;
+    vec3 color;
+};
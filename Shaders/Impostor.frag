@@ -0,0 +1,43 @@
+#version 330 core
+
+out vec4 FragColor;
+
+in vec2 AlbedoCoords;
+in vec2 NormalCoords;
+in float Fade;
+flat in mat3 ModelRotation;
+
+#include "FrameUniforms.glsl"
+
+uniform sampler2D atlas;
+
+vec3 CalcDirLight(vec3 normal, vec3 diffTex) {
+    vec3 lightDir = normalize(-light.direction);
+    float diff = max(dot(normal, lightDir), 0.0);
+    return light.ambient * diffTex + light.diffuse * diff * diffTex;
+}
+
+// Ordered dither threshold, so a fading impostor drops whole pixels
+// instead of blending and needs no sorting against the model it replaces
+float Threshold(vec2 pixel) {
+    const float bayer[16] = float[](0.0, 8.0, 2.0, 10.0,
+                                    12.0, 4.0, 14.0, 6.0,
+                                    3.0, 11.0, 1.0, 9.0,
+                                    15.0, 7.0, 13.0, 5.0);
+    ivec2 cell = ivec2(mod(pixel, 4.0));
+    return (bayer[cell.y * 4 + cell.x] + 0.5) / 16.0;
+}
+
+void main()
+{
+    vec4 albedo = texture(atlas, AlbedoCoords);
+    if (albedo.a < 0.5 || Fade < Threshold(gl_FragCoord.xy))
+        discard;
+
+    vec3 finalColor = albedo.rgb;
+#ifdef USE_LIGHTS
+    vec3 normal = normalize(ModelRotation * (texture(atlas, NormalCoords).rgb * 2.0 - 1.0));
+    finalColor = CalcDirLight(normal, finalColor);
+#endif
+    FragColor = vec4(finalColor, 1.0);
+}
@@ -0,0 +1,50 @@
+#version 330 core
+
+layout(location = 0) in vec2 aCorner; // (+-1, +-1)
+
+layout(location = 8) in vec4 instanceModel0;
+layout(location = 9) in vec4 instanceModel1;
+layout(location = 10) in vec4 instanceModel2;
+layout(location = 11) in vec4 instanceModel3;
+
+out vec2 AlbedoCoords;
+out vec2 NormalCoords;
+out float Fade;
+flat out mat3 ModelRotation;
+
+#include "FrameUniforms.glsl"
+
+uniform vec3 uCenter;   // of the model's bounds, in model space
+uniform float uRadius;  // half the width of what a tile shows
+uniform float uBoundsRadius;
+uniform int uViews;
+uniform float uFadeInner;
+uniform float uFadeOuter;
+
+void main() {
+    mat4 model = mat4(instanceModel0, instanceModel1, instanceModel2, instanceModel3);
+    vec3 center = (model * vec4(uCenter, 1.0)).xyz;
+    float scale = length(model[0].xyz);
+
+    // Turned about the vertical axis only, like the views were taken
+    vec3 eye = -(transpose(mat3(uView)) * uView[3].xyz);
+    vec3 toEye = eye - center;
+    vec3 facing = vec3(toEye.x, 0.0, toEye.z);
+    facing = length(facing) > 1e-4 ? normalize(facing) : vec3(0.0, 0.0, 1.0);
+    vec3 right = normalize(cross(-facing, vec3(0.0, 1.0, 0.0)));
+    vec3 world = center + (right * aCorner.x + vec3(0.0, aCorner.y, 0.0)) * uRadius * scale;
+    gl_Position = uProjection * uView * vec4(world, 1.0);
+
+    // The view taken from the direction nearest the camera's, in model space
+    ModelRotation = mat3(normalize(model[0].xyz), normalize(model[1].xyz), normalize(model[2].xyz));
+    vec3 local = transpose(ModelRotation) * facing;
+    float step = 6.28318530718 / float(uViews);
+    float view = mod(floor(atan(local.x, local.z) / step + 0.5), float(uViews));
+    vec2 inTile = aCorner * 0.5 + 0.5;
+    AlbedoCoords = vec2((view + inTile.x) / float(uViews), inTile.y * 0.5);
+    NormalCoords = AlbedoCoords + vec2(0.0, 0.5);
+
+    // Same screen coverage measure the culler picks levels of detail with
+    float coverage = uBoundsRadius * scale * uProjection[1][1] / max(length(toEye), 1e-4);
+    Fade = clamp((uFadeOuter - coverage) / (uFadeOuter - uFadeInner), 0.0, 1.0);
+}
@@ -0,0 +1,24 @@
+#version 330 core
+
+out vec4 FragColor;
+
+in vec2 TexCoords;
+in vec3 Normal;
+
+uniform sampler2D diffuse1;
+uniform bool uHasTexture;
+// The atlas's upper row stores normals, packed into [0, 1], in place of
+// the colour
+uniform bool uOutputNormal;
+
+void main()
+{
+    vec4 albedo = uHasTexture ? texture(diffuse1, TexCoords) : vec4(0.8, 0.8, 0.8, 1.0);
+    if (albedo.a < 0.5)
+        discard;
+
+    if (uOutputNormal)
+        FragColor = vec4(normalize(Normal) * 0.5 + 0.5, 1.0);
+    else
+        FragColor = vec4(albedo.rgb, 1.0);
+}
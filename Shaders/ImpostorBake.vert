@@ -0,0 +1,17 @@
+#version 330 core
+
+layout(location = 0) in vec3 aPos;
+layout(location = 1) in vec3 aNormal;
+layout(location = 3) in vec2 aTexCoords;
+
+out vec2 TexCoords;
+out vec3 Normal;
+
+// An orthographic side view of the model, in model space
+uniform mat4 uViewProjection;
+
+void main() {
+    TexCoords = aTexCoords;
+    Normal = aNormal;
+    gl_Position = uViewProjection * vec4(aPos, 1.0);
+}
@@ -1,7 +1,13 @@
 #version 440 core
 
-#define MAX_TEXTURE_UNITS 16
-#define MAX_COLOR_UNITS 32
+// Compiled per feature set: TEXTURED picks textures over colours, and the
+// layer counts are fixed so the loops below have constant bounds
+#ifndef TEXTURE_COUNT
+#define TEXTURE_COUNT 0
+#endif
+#ifndef COLOR_COUNT
+#define COLOR_COUNT 0
+#endif
 
 in vec3 vertexNormal;
 in vec3 vertexColor;
@@ -22,45 +28,35 @@ struct ColorData {
 	float height;
 };
 
-struct Light {
-	vec3 direction;
-	vec3 ambient;
-	vec3 diffuse;
-};
+#include "FrameUniforms.glsl"
 
-uniform int textureCount;
-uniform LoadedTexture loadedTextures[MAX_TEXTURE_UNITS];
-uniform int colorCount;
-uniform ColorData colors[MAX_COLOR_UNITS];
-uniform bool coloringMode;
+#if defined(TEXTURED) && TEXTURE_COUNT > 0
+uniform LoadedTexture loadedTextures[TEXTURE_COUNT];
+#endif
+#if !defined(TEXTURED) && COLOR_COUNT > 0
+uniform ColorData colors[COLOR_COUNT];
+#endif
 uniform sampler2D heightmap;
 
-uniform Light light;
-uniform bool useLights = true;
-
+#ifdef TEXTURED
 vec4 CalcTexColor() {
+#if TEXTURE_COUNT == 0
+	return vec4(1.0);
+#elif TEXTURE_COUNT == 1
+	vec2 texCoord = vertexTexCoord * loadedTextures[0].tiling + loadedTextures[0].offset;
+	return texture(loadedTextures[0].texture, texCoord);
+#else
 	vec4 TexColor = vec4(1.0);
-
-	if(textureCount == 0) {
-		return TexColor;
-	}
-
 	float Height = texture(heightmap, vertexTexCoord).r;
 
-	if(textureCount == 1) {
-		vec2 texCoord = vertexTexCoord * loadedTextures[0].tiling + loadedTextures[0].offset;
-		TexColor = texture(loadedTextures[0].texture, texCoord);
-		return TexColor;
-	}
-
 	if(Height < loadedTextures[0].height) {
 		vec2 texCoord = vertexTexCoord * loadedTextures[0].tiling + loadedTextures[0].offset;
 		TexColor = texture(loadedTextures[0].texture, texCoord);
-	} else if(Height > loadedTextures[textureCount - 1].height) {
-		vec2 texCoord = vertexTexCoord * loadedTextures[textureCount - 1].tiling + loadedTextures[textureCount - 1].offset;
-		TexColor = texture(loadedTextures[textureCount - 1].texture, texCoord);
+	} else if(Height > loadedTextures[TEXTURE_COUNT - 1].height) {
+		vec2 texCoord = vertexTexCoord * loadedTextures[TEXTURE_COUNT - 1].tiling + loadedTextures[TEXTURE_COUNT - 1].offset;
+		TexColor = texture(loadedTextures[TEXTURE_COUNT - 1].texture, texCoord);
 	} else {
-		for(int i = 0; i < textureCount - 1; i++) {
+		for(int i = 0; i < TEXTURE_COUNT - 1; i++) {
 			if(Height >= loadedTextures[i].height && Height <= loadedTextures[i + 1].height) {
 				vec2 texCoord0 = vertexTexCoord * loadedTextures[i].tiling + loadedTextures[i].offset;
 				vec2 texCoord1 = vertexTexCoord * loadedTextures[i + 1].tiling + loadedTextures[i + 1].offset;
@@ -75,25 +71,27 @@ vec4 CalcTexColor() {
 	}
 
 	return TexColor;
+#endif
 }
-
+#else
 vec4 CalcColor() {
-	if(colorCount == 0) {
-		return vec4(1.0);
-	}
-
+#if COLOR_COUNT == 0
+	return vec4(1.0);
+#else
 	float Height = texture(heightmap, vertexTexCoord).r;
 	if(Height <= colors[0].height)
 		return colors[0].color;
 
-	for(int i = 0; i < colorCount - 1; i++) {
+	for(int i = 0; i < COLOR_COUNT - 1; i++) {
 		if(Height <= colors[i].height) {
 			return colors[i].color;
 		}
 	}
 
-	return colors[colorCount - 1].color;
+	return colors[COLOR_COUNT - 1].color;
+#endif
 }
+#endif
 
 vec3 CalcDirLight(vec3 normal, vec3 diffTex) {
 	vec3 lightDir = normalize(-light.direction);
@@ -108,19 +106,18 @@ vec3 CalcDirLight(vec3 normal, vec3 diffTex) {
 }
 
 void main() {
-	vec4 finalColor = vec4(1.0);
-	if(coloringMode) {
-		finalColor = CalcTexColor();
-	} else {
-		finalColor = CalcColor();
-	}
-
-	if(useLights) {
-  		// calculate lighting
-		vec3 normal = normalize(vertexNormal);
-		vec3 lightColor = CalcDirLight(normal, finalColor.rgb);
-		finalColor.rgb = lightColor;
-	}
+#ifdef TEXTURED
+	vec4 finalColor = CalcTexColor();
+#else
+	vec4 finalColor = CalcColor();
+#endif
+
+#ifdef USE_LIGHTS
+	// calculate lighting
+	vec3 normal = normalize(vertexNormal);
+	vec3 lightColor = CalcDirLight(normal, finalColor.rgb);
+	finalColor.rgb = lightColor;
+#endif
 
 	FragColor = finalColor;
 }
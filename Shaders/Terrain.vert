@@ -6,8 +6,8 @@ layout(location = 2) in vec3 aColor;
 layout(location = 3) in vec2 aTexCoord;
 
 uniform mat4 uModel;
-uniform mat4 uView;
-uniform mat4 uProjection;
+
+#include "FrameUniforms.glsl"
 
 out vec3 vertexNormal;
 out vec3 vertexColor;
@@ -13,8 +13,8 @@ layout(location = 10) in vec4 instanceModel2;
 layout(location = 11) in vec4 instanceModel3;
 
 uniform mat4 uModel;
-uniform mat4 uView;
-uniform mat4 uProjection;
+
+#include "FrameUniforms.glsl"
 
 void main() {
     mat4 instanceMatrix = mat4(instanceModel0, instanceModel1, instanceModel2, instanceModel3);
@@ -8,8 +8,8 @@ layout(location = 10) in vec4 instanceModel2;
 layout(location = 11) in vec4 instanceModel3;
 
 uniform mat4 uModel;
-uniform mat4 uView;
-uniform mat4 uProjection;
+
+#include "FrameUniforms.glsl"
 
 out vec3 WorldPos;
 
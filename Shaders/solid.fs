@@ -2,7 +2,7 @@
 
 out vec4 FragColor;
 
-uniform vec3 color = vec3(0.4);
+#include "FrameUniforms.glsl"
 
 void main() {
 	FragColor = vec4(color, 1.0);
@@ -0,0 +1,47 @@
+#pragma once
+
+#include <array>
+#include <cfloat>
+#include <glm/glm.hpp>
+
+// Axis-aligned box; empty until a point is added.
+struct Bounds {
+  glm::vec3 min = glm::vec3(FLT_MAX);
+  glm::vec3 max = glm::vec3(-FLT_MAX);
+
+  bool IsEmpty() const { return min.x > max.x; }
+  void Add(const glm::vec3 &point) {
+    min = glm::min(min, point);
+    max = glm::max(max, point);
+  }
+  void Add(const Bounds &other) {
+    min = glm::min(min, other.min);
+    max = glm::max(max, other.max);
+  }
+  glm::vec3 Center() const { return (min + max) * 0.5f; }
+  glm::vec3 Extents() const { return (max - min) * 0.5f; }
+  // Radius of the sphere around Center() that holds the box.
+  float Radius() const { return glm::length(Extents()); }
+
+  // The box around this one after transforming it by matrix.
+  Bounds Transformed(const glm::mat4 &matrix) const;
+};
+
+// The six planes of a view-projection volume with their normals pointing
+// inwards, scaled so a plane's w plus its dot product with a point is the
+// point's distance from it in world units.
+class Frustum {
+public:
+  enum Result { kOutside, kIntersects, kInside };
+
+  Frustum() = default;
+  explicit Frustum(const glm::mat4 &viewProjection);
+
+  Result TestBox(const Bounds &box) const;
+  bool IntersectsSphere(const glm::vec3 &center, float radius) const;
+  // Left, right, bottom, top, near, far.
+  const std::array<glm::vec4, 6> &Planes() const { return planes; }
+
+private:
+  std::array<glm::vec4, 6> planes;
+};
@@ -0,0 +1,33 @@
+#pragma once
+
+#include <array>
+
+// Remembers the program, texture and vertex array bindings made through it
+// and skips calls that would rebind what is already bound. GL calls made
+// around it, such as ImGui's own rendering or resource uploads, leave the
+// cache stale, so the renderer invalidates it at the start of every frame.
+class GLState {
+public:
+  static void Invalidate();
+
+  static void UseProgram(unsigned int program);
+  // unit is GL_TEXTURE0 + n, as for glActiveTexture.
+  static void ActiveTexture(unsigned int unit);
+  // Binds a 2D texture to the active unit.
+  static void BindTexture2D(unsigned int texture);
+  static void BindVertexArray(unsigned int vertexArray);
+
+  // Deleting an object unbinds it and frees its name for reuse, so deletes
+  // go through here to drop it from the cache as well.
+  static void DeleteTexture(unsigned int texture);
+  static void DeleteVertexArray(unsigned int vertexArray);
+
+private:
+  static constexpr unsigned int kUnknown = ~0u;
+  static constexpr int kTrackedUnits = 32;
+
+  static unsigned int program;
+  static unsigned int activeUnit; // n of GL_TEXTURE0 + n
+  static unsigned int vertexArray;
+  static std::array<unsigned int, kTrackedUnits> textures;
+};
@@ -0,0 +1,31 @@
+#pragma once
+
+// Measures how long the GPU spends on the GL work between Begin() and End()
+// without waiting for it. Measurements rotate through a few queries and
+// are read back by Poll() once the GPU has finished them, usually a frame
+// or two later. Queries are created on first use, once a GL context is
+// current.
+class GpuTimer {
+public:
+  GpuTimer() = default;
+  ~GpuTimer();
+  GpuTimer(const GpuTimer &) = delete;
+  GpuTimer &operator=(const GpuTimer &) = delete;
+
+  // A Begin() while every query is still in flight is skipped along with
+  // its End(), rather than stalling on the oldest.
+  void Begin();
+  void End();
+
+  // Sets milliseconds to the latest measurement finished since the last
+  // call and returns true, or returns false if none has.
+  bool Poll(float &milliseconds);
+
+private:
+  static constexpr int kQueries = 3;
+
+  unsigned int queries[kQueries] = {};
+  bool pending[kQueries] = {};
+  int next = 0;         // query the next Begin() uses; the oldest in flight
+  bool timing = false;  // between a Begin() that started a query and End()
+};
@@ -0,0 +1,62 @@
+#pragma once
+
+#include <cstddef>
+#include <glm/glm.hpp>
+
+// Per-frame uniform blocks shared by every shader. Shader binds blocks with
+// these names to these points when it links, and the renderer fills them
+// once per frame, so draws only set what differs per mesh.
+//
+// Shaders declare the blocks by including Shaders/FrameUniforms.glsl, which
+// must match the std140 layouts below member for member. std140 starts
+// every vec3 on 16 bytes, so the padding members stand for the gaps after
+// the vec3s that no float follows; viewport features such as lighting and
+// filled wireframes are shader defines, not flags in here.
+namespace FrameUniforms {
+constexpr unsigned int kCameraBinding = 0;
+constexpr unsigned int kShadingBinding = 1;
+constexpr const char *kCameraBlock = "Camera";
+constexpr const char *kShadingBlock = "Shading";
+
+struct Camera {
+  glm::mat4 view;
+  glm::mat4 projection;
+};
+
+struct Shading {
+  glm::vec3 lightDirection;
+  float pad0;
+  glm::vec3 lightAmbient;
+  float pad1;
+  glm::vec3 lightDiffuse;
+  float pad2;
+  glm::vec3 wireframeColor;
+  float wireframeWidth;
+  glm::vec3 fillColor;
+  float pad3;
+  glm::vec3 solidColor;
+  float pad4;
+};
+static_assert(offsetof(Shading, fillColor) == 64 &&
+                  offsetof(Shading, solidColor) == 80,
+              "Shading must match its std140 layout");
+static_assert(sizeof(Shading) == 96, "Shading must round up to a vec4");
+} // namespace FrameUniforms
+
+// A uniform buffer object of fixed size, bound to one binding point for its
+// whole lifetime.
+class UniformBuffer {
+public:
+  UniformBuffer(unsigned int binding, size_t size);
+  ~UniformBuffer();
+  UniformBuffer(const UniformBuffer &) = delete;
+  UniformBuffer &operator=(const UniformBuffer &) = delete;
+
+  void Update(const void *data, size_t size, size_t offset = 0);
+  unsigned int GetBinding() const { return binding; }
+
+private:
+  unsigned int ID = 0;
+  unsigned int binding;
+  size_t size;
+};
@@ -0,0 +1,63 @@
+#pragma once
+
+#include <glm/glm.hpp>
+#include <string>
+#include <vector>
+
+class Model;
+
+// A stand-in for a model seen from far away: a camera-facing quad textured
+// with a picture of the model. The pictures are taken once per model from
+// kViews directions around its vertical axis and kept as an atlas in
+// kCacheDirectory, so later runs load them instead of rendering again; the
+// quad shows the view nearest to the direction it is seen from.
+//
+// The atlas holds two rows of kViews tiles: the model's unlit colour below
+// and its normals, in model space, above, so impostors are lit by the
+// current light like the model is.
+class Impostor {
+public:
+  static constexpr int kViews = 8;
+  static constexpr int kTileSize = 128;
+  static constexpr const char *kCacheDirectory = "Cache/Impostors";
+  // Bumped whenever the bake shader or the atlas layout changes, so cached
+  // atlases from before are baked again.
+  static constexpr int kCacheVersion = 1;
+
+  // Loads the atlas for the model at modelPath from the cache, or renders
+  // and caches it. Needs a current GL context.
+  Impostor(Model &model, const std::string &modelPath);
+  ~Impostor();
+  Impostor(const Impostor &) = delete;
+  Impostor &operator=(const Impostor &) = delete;
+
+  bool IsReady() const { return atlas != 0; }
+
+  // Draws an impostor for each transform. One whose model spans fadeOuter
+  // of the screen height or more is left out and one at fadeInner or less
+  // is drawn in full; in between it dissolves in, so it can overlap the
+  // model itself while the model still draws. Unlit impostors show the
+  // model's colour as is.
+  void Draw(const std::vector<glm::mat4> &instances, float fadeInner,
+            float fadeOuter, bool lit);
+
+private:
+  std::string cachePath(const std::string &modelPath) const;
+  bool loadCached(const std::string &path, const std::string &modelPath);
+  void writeCache(const std::string &path,
+                  const std::vector<unsigned char> &pixels) const;
+  // False if the bake shader is missing.
+  bool bake(Model &model, std::vector<unsigned char> &pixels);
+  void upload(const unsigned char *pixels, int width, int height);
+  void setupQuad();
+  // A little margin keeps the model off the tile edges, where mipmapping
+  // would bleed the neighbouring view in
+  float tileRadius() const { return radius * 1.05f; }
+
+  // The model's bounding sphere
+  glm::vec3 center = glm::vec3(0.0f);
+  float radius = 0.0f;
+
+  unsigned int atlas = 0;
+  unsigned int arrayObj = 0, quadBuffer = 0, instanceBuffer = 0;
+};
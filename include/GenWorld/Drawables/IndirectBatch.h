@@ -0,0 +1,63 @@
+#pragma once
+
+#include <glm/glm.hpp>
+#include <memory>
+#include <utility>
+#include <vector>
+
+class Mesh;
+class Model;
+
+// Instanced models packed into one vertex, index and instance arena and
+// drawn with glMultiDrawElementsIndirect: one indirect command per submesh
+// and one multi-draw per material, however many models share it. Needs a
+// GL 4.3 context; callers fall back to Model::DrawInstanced without one.
+class IndirectBatch {
+public:
+  // A model and the transforms of its instances. The transforms are copied;
+  // the model's meshes supply the materials and must outlive the batch.
+  using Source = std::pair<Model *, const std::vector<glm::mat4> *>;
+
+  IndirectBatch(const std::vector<Source> &sources);
+  ~IndirectBatch();
+  IndirectBatch(const IndirectBatch &) = delete;
+  IndirectBatch &operator=(const IndirectBatch &) = delete;
+
+  static bool IsSupported();
+  // A source draws through one list per level of detail of its model. The
+  // lists are numbered source by source, coarser levels after finer ones.
+  static int LevelCount(const Source &source);
+
+  // Replaces the instances of every draw list, e.g. with the ones left
+  // after culling. The batch starts with each source's instances at its
+  // finest level. Only the instance and command buffers are uploaded.
+  void SetInstances(const std::vector<const std::vector<glm::mat4> *> &lists);
+
+  void Draw();
+  size_t CommandCount() const { return commands.size(); }
+  size_t GroupCount() const { return groups.size(); }
+
+private:
+  // Layout glMultiDrawElementsIndirect reads from the indirect buffer
+  struct Command {
+    unsigned int count;
+    unsigned int instanceCount;
+    unsigned int firstIndex;
+    int baseVertex;
+    unsigned int baseInstance;
+  };
+  struct Group {
+    Mesh *material; // any submesh with this texture set
+    size_t firstCommand, commandCount;
+  };
+
+  void uploadInstances(const std::vector<glm::mat4> &instances);
+
+  std::vector<Group> groups;
+  std::vector<Command> commands;
+  std::vector<std::vector<size_t>> listCommands; // [list]
+  std::vector<glm::mat4> instanceScratch;
+  unsigned int arrayObj = 0;
+  unsigned int vertexBuffer = 0, indexBuffer = 0;
+  unsigned int instanceBuffer = 0, commandBuffer = 0;
+};
@@ -0,0 +1,96 @@
+#pragma once
+
+#include <GenWorld/Core/Frustum.h>
+#include <GenWorld/Drawables/IndirectBatch.h>
+#include <cstdint>
+#include <vector>
+
+// Frustum culling and level of detail selection for instanced models. The
+// instances of all sources go into one bounding volume hierarchy, built
+// once from the models' bounds; each frame Cull() walks it and sorts the
+// transforms of the instances the camera can see into draw lists, one per
+// source and level of detail (see IndirectBatch::LevelCount). Far enough
+// away, instances of a source with an impostor go to its impostor list
+// instead.
+class InstanceCuller {
+public:
+  // The same sources an IndirectBatch takes. The transforms are read on
+  // every Cull() and must not change after construction.
+  using Source = IndirectBatch::Source;
+
+  explicit InstanceCuller(const std::vector<Source> &sources);
+
+  // An instance spanning less than kImpostorCoverage * kImpostorFade of the
+  // screen height is listed for its source's impostor, and below
+  // kImpostorCoverage for the impostor alone; in between it is in both
+  // while the impostor fades in.
+  static constexpr float kImpostorCoverage = 0.012f;
+  static constexpr float kImpostorFade = 1.5f;
+
+  void Cull(const glm::mat4 &view, const glm::mat4 &projection);
+  // Lists the source's far instances for an impostor from the next Cull().
+  void EnableImpostor(size_t source);
+  // While off, Cull() lists no impostors and far instances draw with their
+  // coarsest level instead, e.g. in viewport modes the impostor atlas
+  // cannot show. On by default.
+  void SetImpostorsActive(bool active) { impostorsActive = active; }
+
+  // Visible transforms of each draw list as of the last Cull().
+  const std::vector<const std::vector<glm::mat4> *> &Visible() const {
+    return visibleLists;
+  }
+  // Transforms for each source's impostor as of the last Cull().
+  const std::vector<glm::mat4> &Impostors(size_t source) const {
+    return impostors[source];
+  }
+  const std::vector<Source> &Sources() const { return sources; }
+  size_t ListSource(size_t list) const { return listSource[list]; }
+  int ListLevel(size_t list) const { return listLevel[list]; }
+  size_t VisibleCount() const { return visibleCount; }
+  size_t InstanceCount() const { return radius.size(); }
+
+private:
+  static constexpr uint32_t kLeafSize = 8;
+  // An instance whose bounding sphere spans less than kLodCoverage[n] of
+  // the screen height draws with level n + 1 or coarser, if its model has
+  // that level
+  static constexpr float kLodCoverage[] = {0.15f, 0.06f, 0.025f};
+
+  // Children of an inner node are the next node and `right`; the
+  // instances under any node are [first, first + count) in tree order.
+  struct Node {
+    Bounds box;
+    uint32_t first, count;
+    uint32_t right; // 0 for a leaf
+  };
+
+  uint32_t build(std::vector<uint32_t> &order, uint32_t first, uint32_t count,
+                 const std::vector<glm::vec4> &spheres);
+  void addRange(uint32_t first, uint32_t count);
+  void testLeaf(const Node &leaf, const Frustum &frustum);
+
+  std::vector<Node> nodes;
+  // Instance spheres in tree order, one array per component so the leaf
+  // test runs over them a plane at a time
+  std::vector<float> centerX, centerY, centerZ, radius;
+  std::vector<uint32_t> sourceOf, indexOf; // [tree order]
+  // The model's own bounding radius times the instance's scale, as the
+  // impostor shader measures it; the world box around a turned model is
+  // larger
+  std::vector<float> modelRadius; // [tree order]
+
+  std::vector<Source> sources;
+  std::vector<size_t> firstList; // [source], plus the total at the end
+  std::vector<size_t> listSource;
+  std::vector<int> listLevel;
+  std::vector<std::vector<glm::mat4>> visible; // [list]
+  std::vector<const std::vector<glm::mat4> *> visibleLists;
+  std::vector<uint8_t> impostorEnabled;         // [source]
+  std::vector<std::vector<glm::mat4>> impostors; // [source]
+  bool impostorsActive = true;
+  size_t visibleCount = 0;
+
+  // Camera of the current Cull(), for picking levels of detail
+  glm::vec3 eye = glm::vec3(0.0f);
+  float lodScale = 0.0f;
+};
@@ -0,0 +1,42 @@
+#pragma once
+
+#include <memory>
+#include <string>
+#include <vector>
+
+class Model;
+
+// Immutable snapshot of the loaded block assets, taken once per generation.
+// Assets are stored in load order and looked up through a dense id -> slot
+// table, so per-block queries in the mesh and solver loops are one index
+// instead of a copy and a linear search of the UI's asset list.
+class AssetRegistry {
+public:
+  struct Entry {
+    int id;
+    std::string name;
+    std::string path;
+    std::shared_ptr<Model> model;
+  };
+
+  // Ids are expected to be small and non-negative, as the UI assigns them;
+  // negative ids and repeated ids after the first are ignored.
+  void Add(int id, const std::string &name, const std::string &path,
+           const std::shared_ptr<Model> &model);
+
+  bool Empty() const { return entries.empty(); }
+  int Size() const { return static_cast<int>(entries.size()); }
+  const std::vector<Entry> &Entries() const { return entries; }
+
+  // Returns nullptr for ids that were never added.
+  const Entry *Find(int id) const {
+    if (id < 0 || id >= static_cast<int>(slots.size()) || slots[id] < 0)
+      return nullptr;
+    return &entries[slots[id]];
+  }
+  bool Contains(int id) const { return Find(id) != nullptr; }
+
+private:
+  std::vector<Entry> entries;
+  std::vector<int> slots; // [id] -> index into entries, or -1
+};
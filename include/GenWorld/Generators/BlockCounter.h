@@ -0,0 +1,71 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+// Placement counts for the min/max block constraints, kept in dense tables
+// indexed by block id. Every query is a single lookup, and the changes
+// solvers care about come back from Add(): a block reaching its maximum, or
+// a block entering or leaving the set still short of its minimum.
+//
+// Ids at or above the limit given to Reset() count as unconstrained.
+class BlockCounter {
+public:
+  enum Change : int { kNone = 0, kSaturation = 1, kDeficit = 2 };
+
+  // Sizes the tables for ids below idLimit and clears all counts and limits.
+  void Reset(int idLimit);
+  // maxCount < 0 means unlimited. Exempt blocks are never saturated and
+  // never short of their minimum, as corner pieces are placed separately.
+  void SetLimits(int blockId, int minCount, int maxCount, bool isExempt);
+  // variantBlocks[v] is the block id of variant v; this sizes the
+  // saturated-variant mask to `words` 64-bit words.
+  void SetVariants(const std::vector<int> &variantBlocks, int words);
+
+  // Adds delta to the block's count and returns the Change bits it caused.
+  int Add(int blockId, int delta);
+
+  int IdLimit() const { return static_cast<int>(counts.size()); }
+  int Count(int blockId) const { return known(blockId) ? counts[blockId] : 0; }
+  // Placements left before the maximum, ignoring exemptions; INT_MAX when
+  // the block is unlimited.
+  int Remaining(int blockId) const;
+  bool CanPlace(int blockId) const {
+    return !known(blockId) || !saturated[blockId];
+  }
+  // True while the block is below its minimum and can still be placed.
+  bool NeedsMin(int blockId) const {
+    return known(blockId) && deficitSlot[blockId] >= 0;
+  }
+  // How far the block is below its minimum, 0 once it is reached.
+  int Shortfall(int blockId) const;
+  bool MinimumsMet() const { return shortBlocks == 0; }
+  // The blocks for which NeedsMin() holds, in no particular order.
+  const std::vector<int> &Deficits() const { return deficits; }
+  // One bit per variant whose block is saturated.
+  const uint64_t *SaturatedMask() const { return saturatedMask.data(); }
+
+private:
+  bool known(int blockId) const {
+    return blockId >= 0 && blockId < static_cast<int>(counts.size());
+  }
+  bool isShort(int blockId) const {
+    return !exempt[blockId] && counts[blockId] < minCounts[blockId];
+  }
+  bool isSaturated(int blockId) const {
+    return !exempt[blockId] && maxCounts[blockId] >= 0 &&
+           counts[blockId] >= maxCounts[blockId];
+  }
+  // Brings the saturation bit, mask and deficit set in line with the count.
+  int update(int blockId);
+
+  std::vector<int> counts, minCounts, maxCounts; // [blockId]
+  std::vector<uint8_t> exempt, saturated;        // [blockId]
+  std::vector<uint8_t> shortOf;                  // [blockId]
+  int shortBlocks = 0;
+  std::vector<int> deficits;
+  std::vector<int> deficitSlot; // [blockId] -> index into deficits, or -1
+
+  std::vector<std::vector<int>> blockVariants; // [blockId]
+  std::vector<uint64_t> saturatedMask;
+};
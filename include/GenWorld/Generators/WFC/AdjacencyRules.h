@@ -0,0 +1,80 @@
+#pragma once
+
+#include <GenWorld/Generators/WFC/VariantMask.h>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <utility>
+#include <vector>
+
+namespace WFC {
+// Face indices: [+X=0, -X=1, +Y=2, -Y=3, +Z=4, -Z=5]
+constexpr int kFaceCount = 6;
+inline int OppositeFace(int face) { return face ^ 1; }
+
+struct Variant {
+  int blockId;
+  int rotation;
+  // Every rotation that gives the block these sockets, `rotation` first.
+  // They are interchangeable to the solver; a cell picks one as it collapses.
+  std::vector<int> rotations;
+};
+
+// Dense numbering of (block, rotation) pairs plus, for every variant and
+// face, the bitset of variants allowed in the neighbouring cell on that side.
+class AdjacencyRules {
+public:
+  void Clear();
+
+  // Variants must all be added before Finalize(); Allow() comes after.
+  int AddVariant(int blockId, int rotation);
+  // Makes FindVariant(blockId, rotation) resolve to an existing variant
+  // whose sockets that rotation reproduces.
+  void AddRotation(int variant, int rotation);
+  void Finalize();
+  void Allow(int variant, int face, int neighborVariant);
+  // Bulk form of Allow() for rules that depend only on a type per face:
+  // u allows v across `face` iff connects(type(v, opposite), type(u, face)).
+  // faceTypes is [variant][face]. Variants are bucketed by type per face and
+  // the six faces are built concurrently; replaces any earlier Allow() calls.
+  // A face then expects a neighbour whenever its type connects to anything.
+  void AllowByFaceType(const std::vector<uint8_t> &faceTypes, int typeCount,
+                       const std::function<bool(int, int)> &connects);
+
+  int FindVariant(int blockId, int rotation) const;
+  int VariantCount() const { return static_cast<int>(variants.size()); }
+  int WordCount() const { return words; }
+  const Variant &GetVariant(int variant) const { return variants[variant]; }
+
+  // Variants that may occupy the cell across `face` of a cell holding
+  // `variant`.
+  const uint64_t *Compatible(int variant, int face) const {
+    return &compatible[(static_cast<size_t>(variant) * kFaceCount + face) *
+                       words];
+  }
+  // Variants of the neighbour across `face` that allow `variant` here, i.e.
+  // every u with `variant` in Compatible(u, OppositeFace(face)).
+  const uint64_t *Supporters(int variant, int face) const {
+    return &supporters[(static_cast<size_t>(variant) * kFaceCount + face) *
+                       words];
+  }
+
+  // Whether a cell holding `variant` needs a block across `face`, so that an
+  // empty cell there is a dangling socket rather than open air.
+  bool ExpectsNeighbor(int variant, int face) const {
+    return expects[static_cast<size_t>(variant) * kFaceCount + face] != 0;
+  }
+  void SetExpectsNeighbor(int variant, int face, bool expected) {
+    expects[static_cast<size_t>(variant) * kFaceCount + face] = expected;
+  }
+
+private:
+  std::vector<Variant> variants;
+  std::map<std::pair<int, int>, int> variantIndex;
+  std::vector<uint64_t> compatible; // [variant][face][word]
+  std::vector<uint64_t> supporters; // [variant][face][word]
+  std::vector<uint8_t> expects;     // [variant][face]
+  int words = 0;
+};
+} // namespace WFC
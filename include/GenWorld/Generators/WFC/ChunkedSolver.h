@@ -0,0 +1,76 @@
+#pragma once
+
+#include <GenWorld/Generators/WFC/AdjacencyRules.h>
+#include <GenWorld/Generators/WFC/Wave.h>
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <random>
+#include <vector>
+
+namespace WFC {
+// Solves a large grid as full-height columns of chunkSize x chunkSize cells.
+// Chunks are coloured like a checkerboard in x/z. Chunks of one colour share
+// no faces, so all of them are solved at once on a pool of threads: first
+// the black chunks against open edges, then the white ones with a one-cell
+// rim holding what their already solved neighbours chose.
+//
+// Each chunk is its own small Wave with journaling on, so conflicts are
+// first backtracked inside the chunk. A chunk that still leaves dangling
+// sockets is solved again with a fresh seed before its result is kept.
+class ChunkedSolver {
+public:
+  struct Options {
+    int chunkSize = 64;
+    int threads = 0;     // 0 = one per hardware thread
+    int attempts = 3;    // solves per chunk before its conflicts are kept
+    int entryPoints = 3; // bottom-layer cells each chunk starts growing from
+    int backtrackDepth = 64;
+    int maxBacktracks = 2000; // per chunk attempt
+    uint32_t seed = 0;
+    const std::atomic<bool> *cancel = nullptr; // checked between chunks
+  };
+  // Claims a variant for a cell; called from worker threads. Returning
+  // false bans the variant from that cell. Release undoes one claim.
+  using Acquire = std::function<bool(int variant)>;
+  using Release = std::function<void(int variant)>;
+
+  // `domain` is the initial domain of every cell, WordCount() words wide.
+  void Solve(const AdjacencyRules &rules, const std::vector<double> &weights,
+             int width, int height, int length, const uint64_t *domain,
+             const Options &options, const Acquire &acquire = nullptr,
+             const Release &release = nullptr);
+
+  // Chosen variant per cell in Wave::Index() order, -1 for holes.
+  const std::vector<int32_t> &Result() const { return result; }
+  int ChunkCount() const { return static_cast<int>(chunks.size()); }
+  // Sockets still dangling after every attempt.
+  int Conflicts() const { return conflicts; }
+  // False when cancellation skipped chunks, which are then left as holes.
+  bool Complete() const { return solved == ChunkCount(); }
+
+private:
+  struct Chunk {
+    int x0, z0, x1, z1; // [x0, x1) x [z0, z1)
+    int phase;
+  };
+  // Solves one chunk into `result` and returns its dangling sockets.
+  int solveChunk(int chunkIndex, Wave &local);
+  int solveAttempt(const Chunk &chunk, Wave &local, std::mt19937 &rng);
+  int pickVariant(Wave &local, int cell, std::mt19937 &rng) const;
+
+  const AdjacencyRules *rules = nullptr;
+  const std::vector<double> *weights = nullptr;
+  const uint64_t *domain = nullptr;
+  Options options;
+  Acquire acquire;
+  Release release;
+  int width = 0, height = 0, length = 0;
+
+  std::vector<Chunk> chunks;
+  // Written by disjoint chunks within a phase, read across phases only
+  std::vector<int32_t> result;
+  int conflicts = 0;
+  int solved = 0;
+};
+} // namespace WFC
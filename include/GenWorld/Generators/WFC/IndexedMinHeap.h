@@ -0,0 +1,42 @@
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+namespace WFC {
+// Binary min-heap over items 0..capacity-1 with a position index, so any
+// item's key can be changed in place in O(log n). Equal keys pop in item
+// order, which keeps runs reproducible for a given seed.
+class IndexedMinHeap {
+public:
+  void Reset(int capacity);
+
+  bool Empty() const { return heap.empty(); }
+  int Size() const { return static_cast<int>(heap.size()); }
+  bool Contains(int item) const { return positions[item] >= 0; }
+  // Items in heap order; for walking the heap, not for picking the minimum.
+  int ItemAt(int slot) const { return heap[slot].item; }
+
+  // Inserts the item, or moves it to `key` if it is already present.
+  void Push(int item, double key);
+  void Remove(int item);
+  // Returns the item with the lowest key, or -1 when empty.
+  int Top() const { return heap.empty() ? -1 : heap.front().item; }
+  int Pop();
+
+private:
+  struct Entry {
+    double key;
+    int item;
+  };
+  static bool before(const Entry &a, const Entry &b) {
+    return a.key < b.key || (a.key == b.key && a.item < b.item);
+  }
+  void place(size_t slot, const Entry &entry);
+  void siftUp(size_t slot);
+  void siftDown(size_t slot);
+
+  std::vector<Entry> heap;
+  std::vector<int> positions; // [item] -> slot in heap, or -1
+};
+} // namespace WFC
@@ -0,0 +1,62 @@
+#pragma once
+
+#include <type_traits>
+
+namespace WFC {
+// Compile-time neighbourhood of a grid cell: the faces a solver walks, in
+// face order. A single-layer grid never has a neighbour across +-Y, so its
+// lattice leaves those faces out and every loop over it is four steps with
+// no y arithmetic at all.
+template <int... Faces> struct Lattice {
+  static constexpr int kFaceCount = sizeof...(Faces);
+
+  // Calls visit(std::integral_constant<int, face>{}) for every face.
+  template <typename Visit> static void ForEachFace(Visit &&visit) {
+    (visit(std::integral_constant<int, Faces>{}), ...);
+  }
+  // True if pred holds for every face; stops at the first that fails.
+  template <typename Pred> static bool AllFaces(Pred &&pred) {
+    return (pred(std::integral_constant<int, Faces>{}) && ...);
+  }
+};
+using VolumeLattice = Lattice<0, 1, 2, 3, 4, 5>;
+using FlatLattice = Lattice<0, 1, 4, 5>;
+
+// Cell numbering shared by Wave and its solvers: x-major, then y, then z,
+// so the x stride is height * length and the last x layer ends the array.
+struct GridShape {
+  int width = 0, height = 0, length = 0;
+
+  int CellCount() const { return width * height * length; }
+  bool IsFlat() const { return height == 1; }
+
+  // The neighbour across Face, or -1 outside the grid. Only the faces a
+  // lattice names are ever instantiated.
+  template <int Face> int Neighbor(int cell) const {
+    if constexpr (Face == 0)
+      return cell + height * length < CellCount() ? cell + height * length
+                                                   : -1;
+    else if constexpr (Face == 1)
+      return cell >= height * length ? cell - height * length : -1;
+    else if constexpr (Face == 2)
+      return (cell / length) % height + 1 < height ? cell + length : -1;
+    else if constexpr (Face == 3)
+      return (cell / length) % height > 0 ? cell - length : -1;
+    else if constexpr (Face == 4)
+      return cell % length + 1 < length ? cell + 1 : -1;
+    else
+      return cell % length > 0 ? cell - 1 : -1;
+  }
+
+  // Calls visit(face, neighbor) for every neighbour inside the grid.
+  template <typename L, typename Visit>
+  void ForEachNeighbor(int cell, Visit &&visit) const {
+    L::ForEachFace([&](auto face) {
+      constexpr int kFace = decltype(face)::value;
+      int neighbor = Neighbor<kFace>(cell);
+      if (neighbor >= 0)
+        visit(kFace, neighbor);
+    });
+  }
+};
+} // namespace WFC
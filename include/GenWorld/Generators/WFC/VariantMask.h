@@ -0,0 +1,85 @@
+#pragma once
+
+#include <cstdint>
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+// Helpers for fixed-width variant bitsets. A mask is a run of 64-bit words,
+// one bit per dense variant index; the width is fixed per rule set.
+namespace WFC {
+inline int WordsFor(int bitCount) { return (bitCount + 63) / 64; }
+
+inline int PopCount(uint64_t word) {
+#if defined(_MSC_VER)
+  return static_cast<int>(__popcnt64(word));
+#else
+  return __builtin_popcountll(word);
+#endif
+}
+
+inline int CountTrailingZeros(uint64_t word) {
+#if defined(_MSC_VER)
+  unsigned long index;
+  _BitScanForward64(&index, word);
+  return static_cast<int>(index);
+#else
+  return __builtin_ctzll(word);
+#endif
+}
+
+inline bool TestBit(const uint64_t *mask, int bit) {
+  return (mask[bit >> 6] >> (bit & 63)) & 1u;
+}
+
+inline void SetBit(uint64_t *mask, int bit) {
+  mask[bit >> 6] |= uint64_t(1) << (bit & 63);
+}
+
+inline void ClearBit(uint64_t *mask, int bit) {
+  mask[bit >> 6] &= ~(uint64_t(1) << (bit & 63));
+}
+
+inline int CountBits(const uint64_t *mask, int words) {
+  int count = 0;
+  for (int w = 0; w < words; ++w)
+    count += PopCount(mask[w]);
+  return count;
+}
+
+inline bool AnyBit(const uint64_t *mask, int words) {
+  for (int w = 0; w < words; ++w)
+    if (mask[w])
+      return true;
+  return false;
+}
+
+inline bool Intersects(const uint64_t *a, const uint64_t *b, int words) {
+  for (int w = 0; w < words; ++w)
+    if (a[w] & b[w])
+      return true;
+  return false;
+}
+
+// Returns the lowest set bit, or -1 for an empty mask.
+inline int FirstBit(const uint64_t *mask, int words) {
+  for (int w = 0; w < words; ++w)
+    if (mask[w])
+      return (w << 6) + CountTrailingZeros(mask[w]);
+  return -1;
+}
+
+// Calls fn(bit) for every set bit in ascending order. Each word is copied
+// before it is walked, so fn may clear bits of the mask it is iterating.
+template <typename Fn>
+inline void ForEachBit(const uint64_t *mask, int words, Fn &&fn) {
+  for (int w = 0; w < words; ++w) {
+    uint64_t word = mask[w];
+    while (word) {
+      fn((w << 6) + CountTrailingZeros(word));
+      word &= word - 1;
+    }
+  }
+}
+} // namespace WFC
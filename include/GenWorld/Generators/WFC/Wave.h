@@ -0,0 +1,247 @@
+#pragma once
+
+#include <GenWorld/Generators/WFC/AdjacencyRules.h>
+#include <GenWorld/Generators/WFC/IndexedMinHeap.h>
+#include <GenWorld/Generators/WFC/Lattice.h>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <utility>
+#include <vector>
+
+namespace WFC {
+// Cell store for a width x height x length grid. Every per-cell field is a
+// flat array indexed by (x * height + y) * length + z; domains are one run
+// of fixed-width bitsets and a collapsed cell keeps its chosen variant.
+//
+// Propagation is AC-4 style: support[cell][variant][face] counts the
+// variants of the neighbour across `face` that allow `variant` here. A
+// removal decrements the counts of the neighbour variants it allowed, and a
+// variant is banned once one of its counts reaches zero. Any cell may still
+// end up empty, so an uncollapsed neighbour (like a blocked cell or the grid
+// edge) holds an extra "hole" support and can never drive a count to zero.
+// Only counts toward collapsed neighbours are therefore kept: they are built
+// from the neighbour's domain when it collapses, and removals at uncollapsed
+// cells touch no count at all. A collapsed cell holds one variant, so a
+// count is 0 or 1 in practice and a byte holds it.
+//
+// Each cell also keeps sum(w) and sum(w * log w) over its domain, updated as
+// variants are removed and summed lazily after Setup or a weight change. The
+// frontier of open cells is an indexed heap keyed by entropy that is
+// re-keyed on every removal.
+//
+// Neighbour walks are instantiated per lattice: a grid one cell high takes
+// the four-face FlatLattice path, so flat maps never test +-Y. Setup() binds
+// propagation and IsSupported() to their instance once; ForEachNeighbor(),
+// a template over its visitor, picks the lattice once per call. Everything
+// else is the same code for both.
+//
+// With journaling on, every removal, collapse and frontier change is logged
+// so a solver can take a mark before each decision and roll back to it when
+// the decision leads to a contradiction, instead of restarting the grid.
+class Wave {
+public:
+  void Setup(const AdjacencyRules *rules, int width, int height, int length);
+  // Points the wave at an identical copy of its rules, e.g. once both have
+  // moved to another owner.
+  void SetRules(const AdjacencyRules *rules) { this->rules = rules; }
+
+  int Index(int x, int y, int z) const {
+    return (x * shape.height + y) * shape.length + z;
+  }
+  void Position(int cell, int &x, int &y, int &z) const {
+    z = cell % shape.length;
+    y = (cell / shape.length) % shape.height;
+    x = cell / (shape.length * shape.height);
+  }
+  // Returns -1 when the neighbour lies outside the grid.
+  int Neighbor(int cell, int face) const;
+  // Calls visit(face, neighbor) for every neighbour inside the grid, in
+  // face order, through the grid's lattice.
+  template <typename Visit>
+  void ForEachNeighbor(int cell, Visit &&visit) const {
+    if (shape.IsFlat())
+      shape.ForEachNeighbor<FlatLattice>(cell, visit);
+    else
+      shape.ForEachNeighbor<VolumeLattice>(cell, visit);
+  }
+  int CellCount() const { return shape.CellCount(); }
+  bool IsFlat() const { return shape.IsFlat(); }
+  int WordCount() const { return words; }
+
+  const uint64_t *Domain(int cell) const {
+    return &domains[static_cast<size_t>(cell) * words];
+  }
+  void SetDomain(int cell, const uint64_t *mask);
+
+  // The mutators below propagate before returning, so every domain is
+  // consistent with its neighbours between calls.
+  void Ban(int cell, int variant);
+  // Bans every variant for which pred(variant) returns true.
+  template <typename Pred> void BanIf(int cell, Pred &&pred) {
+    ForEachBit(Domain(cell), words, [&](int variant) {
+      if (pred(variant))
+        remove(cell, variant);
+    });
+    propagate();
+  }
+  // Empties the cell; it stays a hole and keeps supporting its neighbours.
+  void Clear(int cell);
+  // Collapses the cell to a single variant.
+  void Assign(int cell, int variant);
+  // Stores a result that is already consistent, e.g. from another wave:
+  // the cell holds only `variant`, or becomes an empty hole for -1. Nothing
+  // is propagated or journaled.
+  void Settle(int cell, int variant);
+  bool IsCollapsed(int cell) const { return chosen[cell] >= 0; }
+  // The variant a collapsed cell holds, or -1.
+  int Chosen(int cell) const { return chosen[cell]; }
+
+  // Blocked cells take no part in generation and constrain nothing.
+  void Block(int cell) { blocked[cell] = 1; }
+  bool IsBlocked(int cell) const { return blocked[cell] != 0; }
+
+  bool IsAllowed(int cell, int variant) const {
+    return TestBit(Domain(cell), variant);
+  }
+  bool IsEmpty(int cell) const { return !AnyBit(Domain(cell), words); }
+  int Count(int cell) const { return CountBits(Domain(cell), words); }
+  // The only remaining variant, or -1 if the domain is not a singleton.
+  int SingleVariant(int cell) const;
+
+  // True if every neighbour still supports `variant` here.
+  bool IsSupported(int cell, int variant) const {
+    return (this->*isSupportedOn)(cell, variant);
+  }
+
+  // Per-variant weights for entropy, 1 until first set. Open cells are
+  // re-keyed at once; every other cell is re-summed when it is next used.
+  void SetWeights(const std::vector<double> &weights);
+  const std::vector<double> &Weights() const { return weights; }
+  // Shannon entropy of the weighted domain; 0 for collapsed or empty cells.
+  double Entropy(int cell) const;
+
+  // Adds the cell to the frontier, keyed by Entropy() + bias. Collapsing a
+  // cell takes it out of the frontier.
+  void Open(int cell, double bias = 0.0);
+  bool IsOpen(int cell) const { return frontier.Contains(cell); }
+  bool HasOpen() const { return !frontier.Empty(); }
+  // Removes and returns the open cell with the lowest key, or -1.
+  int PopLowestEntropy();
+  // Removes every variant in `mask` from every open cell in one pass, e.g.
+  // when a block runs out of placements. Open cells are uncollapsed and
+  // constrain no neighbour, so nothing propagates.
+  void BanOpen(const uint64_t *mask);
+
+  // Cells whose domain shrank, each queued once until it is popped.
+  // Returns -1 when the queue is empty.
+  int PopDirty();
+
+  // Set when an uncollapsed cell runs out of variants next to a collapsed
+  // cell whose socket on that side expects a neighbour.
+  bool HasContradiction() const { return contradiction; }
+  void ClearContradiction() { contradiction = false; }
+
+  // Journaling is off after construction and survives Setup(), which only
+  // drops the entries.
+  void SetJournaling(bool enabled);
+  size_t JournalMark() const { return journalBase + journal.size(); }
+  // Undoes every change made after `mark`, newest first, and clears the
+  // contradiction flag and the dirty queue. onUncollapse(cell, variant) is
+  // called for every collapse that is undone.
+  void Rollback(size_t mark,
+                const std::function<void(int, int)> &onUncollapse);
+  // Forgets the entries before `mark`; the wave can no longer roll back
+  // past it.
+  void CommitJournal(size_t mark);
+
+private:
+  // Whether `holder`, collapsed, backs `variant` in the cell across `face`.
+  bool supportedBy(int holder, int variant, int face) const;
+  template <typename L> bool isSupported(int cell, int variant) const;
+  template <typename L> void propagateOn();
+  bool tracks(int cell) const {
+    return cell >= 0 && !blocked[cell] && chosen[cell] < 0;
+  }
+  // Whether the cell's domain is counted by its neighbours, i.e. it has
+  // dropped its hole support.
+  bool counted(int cell) const { return !blocked[cell] && chosen[cell] >= 0; }
+  uint8_t *supportOf(int cell, int variant) {
+    return &support[(static_cast<size_t>(cell) * rules->VariantCount() +
+                     variant) *
+                    kFaceCount];
+  }
+  // Sets the counts of `cell` across `face` from the domain of `holder`,
+  // the counted neighbour on that side; with `ban`, variants left with no
+  // support are removed.
+  void recount(int cell, int face, int holder, bool ban);
+  // Rebuilds every count toward or from `cell` after its state was set
+  // directly rather than through propagation.
+  void recountAround(int cell);
+  // Lists the open cells in cellScratch.
+  void listOpen();
+  void remove(int cell, int variant);
+  void resum(int cell) const;
+  void markDirty(int cell);
+  void propagate() { (this->*propagateOnShape)(); }
+  void checkExpected(int cell);
+  void record(uint8_t kind, int cell, int value, double bias = 0.0) {
+    if (journaling)
+      journal.push_back({kind, cell, value, bias});
+  }
+
+  // Removal entries use this variant index for a dropped hole support,
+  // after which the neighbours' counts toward the cell are rebuilt.
+  static constexpr int kHole = -1;
+
+  const AdjacencyRules *rules = nullptr;
+  GridShape shape;
+  // The lattice instances for `shape`, bound by Setup()
+  bool (Wave::*isSupportedOn)(int, int) const = nullptr;
+  void (Wave::*propagateOnShape)() = nullptr;
+  int words = 0;
+  std::vector<uint64_t> domains;
+  std::vector<uint8_t> blocked;
+  std::vector<int32_t> chosen;
+  std::vector<uint8_t> support; // [cell][variant][face]
+  // Cells a Rollback() changed, whose counts it rebuilds
+  std::vector<int> rolledBack;
+  std::vector<uint8_t> inRolledBack;
+  // Cells a mutator lists before re-keying them, kept to reuse its capacity
+  std::vector<int> cellScratch;
+  // Cells Rollback() re-keys; apart from cellScratch, as undoing a collapse
+  // calls back into code that may reweight the wave
+  std::vector<int> reopened;
+
+  std::vector<double> weights, weightLogWeights; // [variant]
+  mutable std::vector<double> sumWeights, sumWeightLogWeights;
+  mutable std::vector<uint32_t> sumEpoch; // 0 = never summed
+  uint32_t weightEpoch = 1;
+  std::vector<double> frontierBias;
+  IndexedMinHeap frontier;
+
+  std::vector<std::pair<int, int>> removals; // (cell, variant) to propagate
+  std::vector<int> dirtyQueue;
+  size_t dirtyHead = 0;
+  std::vector<uint8_t> inDirtyQueue;
+  bool contradiction = false;
+
+  enum JournalKind : uint8_t {
+    kRemoved,
+    kAdded,
+    kCollapsed,
+    kOpened,
+    kClosed
+  };
+  struct JournalEntry {
+    uint8_t kind;
+    int32_t cell;
+    int32_t value; // variant, previous choice, or whether the cell was open
+    double bias;   // frontier bias before the change
+  };
+  std::deque<JournalEntry> journal;
+  size_t journalBase = 0; // mark of journal.front()
+  bool journaling = false;
+};
+} // namespace WFC
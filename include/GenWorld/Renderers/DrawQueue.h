@@ -0,0 +1,36 @@
+#pragma once
+
+#include <vector>
+
+class Mesh;
+
+// Mesh draws collected over a frame and replayed sorted by shader, texture
+// set and vertex array, so consecutive draws share as much bound state as
+// possible. While a queue is active, Mesh::Draw and DrawInstanced push an
+// item here instead of drawing.
+class DrawQueue {
+public:
+  struct Item {
+    unsigned int program;
+    unsigned int textures; // first texture of the set, 0 for none
+    unsigned int vertexArray;
+    Mesh *mesh;
+    unsigned int instanceCount; // 0 for a plain draw
+  };
+
+  // Makes this the queue meshes push to until End().
+  void Begin();
+  void Push(const Item &item);
+  // Draws the pending items in state order and empties the queue. A mesh
+  // whose instance buffer is about to change flushes early, as its pending
+  // draw reads that buffer.
+  void Flush();
+  void End();
+
+  static DrawQueue *Active() { return active; }
+
+private:
+  std::vector<Item> items;
+
+  static DrawQueue *active;
+};
@@ -0,0 +1,25 @@
+#pragma once
+
+// Picks the fraction of the viewport's size the scene is rendered at. While
+// the user is moving through the scene, scene renders that take longer on
+// the GPU than kBudgetMilliseconds lower the scale, and cheap ones raise it
+// back; once the interaction stops the scene goes back to full resolution.
+// The scene is stretched over the viewport with linear filtering, so a
+// lower scale shows as a softer image rather than a smaller one.
+class ResolutionScale {
+public:
+  static constexpr float kBudgetMilliseconds = 12.0f;
+  static constexpr float kMinScale = 0.5f;
+
+  // Feeds the GPU time of a scene render, if one finished, and whether the
+  // user is interacting. Returns true if the scale changed.
+  bool Update(bool hasSample, float milliseconds, bool interacting);
+  float Get() const { return scale; }
+
+private:
+  // Scales are multiples of kStep, so the framebuffer is only reallocated
+  // on real changes and not for every bit of timing noise
+  static constexpr float kStep = 0.05f;
+
+  float scale = 1.0f;
+};
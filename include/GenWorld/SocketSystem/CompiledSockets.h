@@ -0,0 +1,31 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Flat snapshot of a SocketSystem for adjacency building: one entry per
+// distinct (block, rotated sockets) variant with its six socket types, and
+// the socket compatibility rules as a bit-matrix over socket types.
+// Rotations of a block that leave its sockets unchanged share one variant;
+// rotations[v] is its representative and rotationSets[v] lists them all.
+struct CompiledSockets {
+  std::vector<int> blockIds;                  // [variant]
+  std::vector<int> rotations;                 // [variant]
+  std::vector<std::vector<int>> rotationSets; // [variant], representative 1st
+  std::vector<uint8_t> faceTypes; // [variant][face]
+  std::vector<uint64_t> connects; // [fromType][toType word]
+  int typeCount = 0;
+  int typeWords = 0;
+
+  int VariantCount() const { return static_cast<int>(blockIds.size()); }
+  int FaceType(int variant, int face) const {
+    return faceTypes[static_cast<size_t>(variant) * 6 + face];
+  }
+  // Same answer as SocketCompatibility::CanConnect(from, to).
+  bool CanConnect(int from, int to) const {
+    return (connects[static_cast<size_t>(from) * typeWords + (to >> 6)] >>
+            (to & 63)) &
+           1u;
+  }
+};
@@ -0,0 +1,21 @@
+#pragma once
+
+#include <GenWorld/Drawables/Mesh.h>
+#include <vector>
+
+// Quadric error metric simplification (Garland and Heckbert) for building
+// levels of detail. Vertices that share a position are treated as one, so
+// meshes split along UV or normal seams still collapse as a whole surface;
+// open borders carry extra error and hold their outline.
+namespace MeshSimplifier {
+// Collapses edges, cheapest first, until at most targetIndexCount indices
+// remain or the next collapse would move the surface more than maxError
+// away from the original. Returns new indices into the same vertices.
+std::vector<unsigned int> Simplify(const std::vector<Vertex> &vertices,
+                                   const std::vector<unsigned int> &indices,
+                                   size_t targetIndexCount, float maxError);
+
+// Returns the vertices the indices use, renumbering the indices to match.
+std::vector<Vertex> Compact(const std::vector<Vertex> &vertices,
+                            std::vector<unsigned int> &indices);
+} // namespace MeshSimplifier
@@ -0,0 +1,57 @@
+#pragma once
+
+#include <string>
+
+namespace Utils {
+// Named timings of the stages of a frame, a generation or an export. A
+// Scope times the block it lives in on the CPU and a GpuScope the GL work
+// issued inside it; scopes opened inside another are shown under it. The
+// last kHistory timings of every scope are kept for the profiler window,
+// and every timing, up to kTraceCapacity, for a Chrome trace
+// (chrome://tracing or ui.perfetto.dev).
+//
+// Scopes are meant for stages, not inner loops: each one takes a lock when
+// it closes. CPU scopes work on any thread; GPU scopes need the GL thread.
+class Profiler {
+public:
+  static constexpr int kHistory = 240;
+  static constexpr size_t kTraceCapacity = 1 << 16;
+
+  class Scope {
+  public:
+    // name must outlive the profiler, as a string literal does.
+    explicit Scope(const char *name);
+    ~Scope();
+    Scope(const Scope &) = delete;
+    Scope &operator=(const Scope &) = delete;
+
+  private:
+    const char *name;
+    double start; // microseconds
+  };
+
+  // Brackets the GL commands between construction and destruction with
+  // timestamp queries. The timing is read back by a later NewFrame(), once
+  // the GPU has caught up.
+  class GpuScope {
+  public:
+    explicit GpuScope(const char *name);
+    ~GpuScope();
+    GpuScope(const GpuScope &) = delete;
+    GpuScope &operator=(const GpuScope &) = delete;
+
+  private:
+    long long id = -1; // -1 when the scope was dropped
+  };
+
+  // Collects finished GPU timings. Call at the start of each frame, on the
+  // GL thread, with no GpuScope open.
+  static void NewFrame();
+  // The per-scope window: latest time and rolling percentiles.
+  static void DrawWindow(bool *open);
+  // Writes the kept timings as Chrome trace events. False if the file
+  // could not be written.
+  static bool ExportTrace(const std::string &path);
+  static void Clear();
+};
+} // namespace Utils
@@ -5,6 +5,7 @@
 #include <GenWorld/Generators/BlockGenerator.h>
 #include <GenWorld/Renderers/Renderer.h>
 #include <GenWorld/UI/BlockUI.h>
+#include <GenWorld/Utils/Profiler.h>
 #include <iostream>
 
 BlockController::BlockController(Renderer *renderer)
@@ -56,6 +57,7 @@ void BlockController::LoadModel(const std::string &filepath) {
 }
 
 void BlockController::Generate() {
+  Utils::Profiler::Scope scope("Generate Blocks");
   UpdateParameters();
 
   Transform currentTransform;
@@ -75,4 +77,5 @@ void BlockController::Generate() {
   if (hasExistingTransform && blockMesh) {
     blockMesh->setTransform(currentTransform);
   }
+  renderer->MarkDirty();
 }
\ No newline at end of file
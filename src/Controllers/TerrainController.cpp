@@ -1,4 +1,5 @@
 #include <GenWorld/Controllers/TerrainController.h>
+#include <GenWorld/Utils/Profiler.h>
 
 TerrainController::TerrainController(Renderer *renderer)
     : GeneratorController(renderer) {
@@ -26,12 +27,14 @@ void TerrainController::UpdateParameters() {
 }
 
 void TerrainController::Generate() {
+  Utils::Profiler::Scope scope("Generate Terrain");
   if (generator.GetParameters() == terrainUI->GetParameters())
     return;
 
   UpdateParameters();
 
   generator.Generate();
+  renderer->MarkDirty();
 }
 
 void TerrainController::DisplayUI() { terrainUI->DisplayUI(); }
\ No newline at end of file
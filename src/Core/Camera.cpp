@@ -73,6 +73,14 @@ glm::mat4 Camera::GetViewMatrix() {
   return glm::lookAt(position, position + front, up);
 }
 
+glm::mat4 Camera::GetProjectionMatrix(float aspectRatio) {
+  return glm::perspective(glm::radians(zoom), aspectRatio, 0.1f, 1000.0f);
+}
+
+Frustum Camera::GetFrustum(float aspectRatio) {
+  return Frustum(GetProjectionMatrix(aspectRatio) * GetViewMatrix());
+}
+
 void Camera::updateCameraVectors() {
   // calculate the new Front vector
   glm::vec3 front;
@@ -2,6 +2,7 @@
 #include <GenWorld/Core/Engine/AppWindow.h>
 #include <GenWorld/Core/stb_image.h>
 #include <GenWorld/Utils/OpenGlInc.h>
+#include <GenWorld/Utils/Profiler.h>
 AppWindow::~AppWindow() { shutdown(); }
 
 bool AppWindow::init() {
@@ -10,8 +11,6 @@ bool AppWindow::init() {
     return false;
   }
 
-  glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
-  glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
   glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
 
 #ifdef __APPLE__
@@ -21,7 +20,18 @@ bool AppWindow::init() {
   // Start in fullscreen mode
   glfwWindowHint(GLFW_MAXIMIZED, GLFW_TRUE);
 
+  // 4.3 enables multi-draw indirect; everything else runs on 3.3
+  window = nullptr;
+#ifndef __APPLE__
+  glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 4);
+  glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
   window = glfwCreateWindow(SCR_WIDTH, SCR_HEIGHT, title.c_str(), NULL, NULL);
+#endif
+  if (!window) {
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
+    window = glfwCreateWindow(SCR_WIDTH, SCR_HEIGHT, title.c_str(), NULL, NULL);
+  }
 
   if (!window) {
     std::cout << "Failed to create GLFW window" << std::endl;
@@ -90,12 +100,24 @@ void AppWindow::newFrame() {
   updateTitle();
 }
 
-void AppWindow::onUpdate() {
+void AppWindow::onUpdate(bool idle) {
   // glfw: swap buffers and poll IO events (keys pressed/released, mouse moved
   // etc.)
   // -------------------------------------------------------------------------------
-  glfwSwapBuffers(window);
-  glfwPollEvents();
+  {
+    // The idle wait below is not frame cost, so only the swap is timed
+    Utils::Profiler::Scope presentScope("Present");
+    glfwSwapBuffers(window);
+  }
+
+  // Once the scene has been still for a few frames, so ImGui's hover and
+  // focus changes have settled, sleep until input arrives. The timeout
+  // keeps the frame rate readout and any pending UI work ticking slowly.
+  idleFrames = idle ? idleFrames + 1 : 0;
+  if (idleFrames > kSettleFrames)
+    glfwWaitEventsTimeout(kIdleTimeout);
+  else
+    glfwPollEvents();
 }
 
 void AppWindow::setViewPortSize(int width, int height) {
@@ -3,6 +3,7 @@
 #include <GenWorld/Core/Engine/Application.h>
 #include <GenWorld/Generators/BlockGenerator.h>
 #include <GenWorld/Generators/TerrainGenerator.h>
+#include <GenWorld/Utils/Profiler.h>
 #include <iostream>
 
 Application *Application::_instance = nullptr;
@@ -88,36 +89,54 @@ void Application::LoadDefaultShaders() {
   ShaderManager *shaderManager = ShaderManager::GetInstance();
   shaderManager->loadShader("solid", "Shaders/VertexShader.vs",
                             "Shaders/solid.fs");
-  shaderManager->loadShader("rendered", "Shaders/VertexShader.vs",
-                            "Shaders/FragmentShader.fs");
-  shaderManager->loadShader("terrain", "Shaders/Terrain.vert",
-                            "Shaders/Terrain.frag");
+  // Compiled again per feature set on first use; see
+  // ShaderManager::getPermutation
+  shaderManager->loadPermutableShader("rendered", "Shaders/VertexShader.vs",
+                                      "Shaders/FragmentShader.fs");
+  shaderManager->loadPermutableShader("terrain", "Shaders/Terrain.vert",
+                                      "Shaders/Terrain.frag");
   shaderManager->loadShader("terrainTexture", "Shaders/TerrainTexture.vert",
                             "Shaders/TerrainTexture.frag");
-  shaderManager->loadShader("wireframe", "Shaders/Wireframe.vs",
-                            "Shaders/Wireframe.fs", "Shaders/Wireframe.gs");
+  shaderManager->loadPermutableShader("wireframe", "Shaders/Wireframe.vs",
+                                      "Shaders/Wireframe.fs",
+                                      "Shaders/Wireframe.gs");
+  shaderManager->loadPermutableShader("impostor", "Shaders/Impostor.vert",
+                                      "Shaders/Impostor.frag");
+  shaderManager->loadShader("impostorBake", "Shaders/ImpostorBake.vert",
+                            "Shaders/ImpostorBake.frag");
 }
 
 void Application::Run() {
   while (m_isRunning && !m_window->shouldClose()) {
-    Utils::Time::Update();
-    CheckGenerationMode();
+    Utils::Profiler::NewFrame();
+    {
+      // Everything but the swap and the wait for input
+      Utils::Profiler::Scope frameScope("Frame");
+      Utils::Time::Update();
+      CheckGenerationMode();
 
-    m_window->newFrame();
+      m_window->newFrame();
 
-    renderer.ClearQueue();
+      renderer.ClearQueue();
 
-    uiCtx.preRender();
+      uiCtx.preRender();
 
-    uiCtx.render();                   // Renders the Main Docking Window
-    generatorController->DisplayUI(); // Renders the TerrainUI Windows
-    generatorController->Update();    // pushes the terrain data to Renderer
+      {
+        Utils::Profiler::Scope uiScope("Panels");
+        uiCtx.render();                   // Renders the Main Docking Window
+        generatorController->DisplayUI(); // Renders the TerrainUI Windows
+        generatorController->Update(); // pushes the terrain data to Renderer
+      }
 
-    m_window->clear();  // Clears the Window
-    sceneView.render(); // Renders the Scene Window
+      m_window->clear(); // Clears the Window
+      {
+        Utils::Profiler::Scope sceneScope("Scene View");
+        sceneView.render(); // Renders the Scene Window
+      }
 
-    uiCtx.postRender();
+      uiCtx.postRender();
+    }
 
-    m_window->onUpdate();
+    m_window->onUpdate(sceneView.IsIdle());
   }
 }
\ No newline at end of file
@@ -1,4 +1,5 @@
 #include <GenWorld/Core/FrameBuffer.h>
+#include <GenWorld/Core/GLState.h>
 #include <GenWorld/Utils/OpenGlInc.h>
 void FrameBuffer::Resize(int width, int height) {
   // Prevent invalid dimensions
@@ -15,7 +16,7 @@ void FrameBuffer::Resize(int width, int height) {
 
   // Clean up existing framebuffer resources
   if (m_ColorTextureID != 0) {
-    glDeleteTextures(1, &m_ColorTextureID);
+    GLState::DeleteTexture(m_ColorTextureID);
     m_ColorTextureID = 0;
   }
 
@@ -33,7 +34,7 @@ void FrameBuffer::Resize(int width, int height) {
 
   // Color attachment
   glGenTextures(1, &m_ColorTextureID);
-  glBindTexture(GL_TEXTURE_2D, m_ColorTextureID);
+  GLState::BindTexture2D(m_ColorTextureID);
   glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, width, height, 0, GL_RGBA,
                GL_UNSIGNED_BYTE, nullptr);
   glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
@@ -63,7 +64,7 @@ void FrameBuffer::unbind() { glBindFramebuffer(GL_FRAMEBUFFER, 0); }
 
 void FrameBuffer::Destroy() {
   if (m_ColorTextureID != 0) {
-    glDeleteTextures(1, &m_ColorTextureID);
+    GLState::DeleteTexture(m_ColorTextureID);
     m_ColorTextureID = 0;
   }
   if (m_DepthStencilID != 0) {
@@ -0,0 +1,53 @@
+#include <GenWorld/Core/Frustum.h>
+
+Bounds Bounds::Transformed(const glm::mat4 &matrix) const {
+  if (IsEmpty())
+    return *this;
+  glm::vec3 center = glm::vec3(matrix * glm::vec4(Center(), 1.0f));
+  glm::mat3 basis(matrix);
+  glm::vec3 extents = Extents();
+  glm::vec3 reach = glm::abs(basis[0]) * extents.x +
+                    glm::abs(basis[1]) * extents.y +
+                    glm::abs(basis[2]) * extents.z;
+  return {center - reach, center + reach};
+}
+
+Frustum::Frustum(const glm::mat4 &viewProjection) {
+  // Each plane is the last row of the matrix plus or minus one of the
+  // others; glm stores columns, so row i is m[0][i], m[1][i], ...
+  auto row = [&](int i) {
+    return glm::vec4(viewProjection[0][i], viewProjection[1][i],
+                     viewProjection[2][i], viewProjection[3][i]);
+  };
+  glm::vec4 w = row(3);
+  for (int axis = 0; axis < 3; ++axis) {
+    planes[axis * 2] = w + row(axis);
+    planes[axis * 2 + 1] = w - row(axis);
+  }
+  for (glm::vec4 &plane : planes)
+    plane /= glm::length(glm::vec3(plane));
+}
+
+Frustum::Result Frustum::TestBox(const Bounds &box) const {
+  Result result = kInside;
+  for (const glm::vec4 &plane : planes) {
+    glm::vec3 normal(plane);
+    // The corners furthest along and against the normal
+    glm::vec3 farthest = glm::mix(box.min, box.max,
+                                  glm::greaterThanEqual(normal, glm::vec3(0)));
+    glm::vec3 nearest = glm::mix(box.max, box.min,
+                                 glm::greaterThanEqual(normal, glm::vec3(0)));
+    if (glm::dot(normal, farthest) + plane.w < 0.0f)
+      return kOutside;
+    if (glm::dot(normal, nearest) + plane.w < 0.0f)
+      result = kIntersects;
+  }
+  return result;
+}
+
+bool Frustum::IntersectsSphere(const glm::vec3 &center, float radius) const {
+  for (const glm::vec4 &plane : planes)
+    if (glm::dot(glm::vec3(plane), center) + plane.w < -radius)
+      return false;
+  return true;
+}
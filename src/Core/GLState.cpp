@@ -0,0 +1,67 @@
+#include <GenWorld/Core/GLState.h>
+#include <GenWorld/Utils/OpenGlInc.h>
+
+unsigned int GLState::program = GLState::kUnknown;
+unsigned int GLState::activeUnit = GLState::kUnknown;
+unsigned int GLState::vertexArray = GLState::kUnknown;
+std::array<unsigned int, GLState::kTrackedUnits> GLState::textures = [] {
+  std::array<unsigned int, kTrackedUnits> unknown;
+  unknown.fill(kUnknown);
+  return unknown;
+}();
+
+void GLState::Invalidate() {
+  program = kUnknown;
+  activeUnit = kUnknown;
+  vertexArray = kUnknown;
+  textures.fill(kUnknown);
+}
+
+void GLState::UseProgram(unsigned int program) {
+  if (GLState::program == program)
+    return;
+  GLState::program = program;
+  glUseProgram(program);
+}
+
+void GLState::ActiveTexture(unsigned int unit) {
+  unsigned int index = unit - GL_TEXTURE0;
+  if (activeUnit == index)
+    return;
+  activeUnit = index;
+  glActiveTexture(unit);
+}
+
+void GLState::BindTexture2D(unsigned int texture) {
+  // Units past the tracked range, or an unknown active unit, always bind
+  if (activeUnit < kTrackedUnits) {
+    if (textures[activeUnit] == texture)
+      return;
+    textures[activeUnit] = texture;
+  }
+  glBindTexture(GL_TEXTURE_2D, texture);
+}
+
+void GLState::BindVertexArray(unsigned int vertexArray) {
+  if (GLState::vertexArray == vertexArray)
+    return;
+  GLState::vertexArray = vertexArray;
+  glBindVertexArray(vertexArray);
+}
+
+void GLState::DeleteTexture(unsigned int texture) {
+  if (texture == 0)
+    return;
+  for (unsigned int &bound : textures)
+    if (bound == texture)
+      bound = 0;
+  glDeleteTextures(1, &texture);
+}
+
+void GLState::DeleteVertexArray(unsigned int vertexArray) {
+  if (vertexArray == 0)
+    return;
+  if (GLState::vertexArray == vertexArray)
+    GLState::vertexArray = 0;
+  glDeleteVertexArrays(1, &vertexArray);
+}
@@ -0,0 +1,46 @@
+#include <GenWorld/Core/GpuTimer.h>
+#include <GenWorld/Utils/OpenGlInc.h>
+
+GpuTimer::~GpuTimer() {
+  if (queries[0] != 0)
+    glDeleteQueries(kQueries, queries);
+}
+
+void GpuTimer::Begin() {
+  if (queries[0] == 0)
+    glGenQueries(kQueries, queries);
+  if (pending[next])
+    return;
+  glBeginQuery(GL_TIME_ELAPSED, queries[next]);
+  timing = true;
+}
+
+void GpuTimer::End() {
+  if (!timing)
+    return;
+  glEndQuery(GL_TIME_ELAPSED);
+  pending[next] = true;
+  next = (next + 1) % kQueries;
+  timing = false;
+}
+
+bool GpuTimer::Poll(float &milliseconds) {
+  // Queries finish in the order they were issued, so the scan stops at the
+  // first one still running
+  bool found = false;
+  for (int i = 0; i < kQueries; ++i) {
+    int query = (next + i) % kQueries;
+    if (!pending[query])
+      continue;
+    GLint available = 0;
+    glGetQueryObjectiv(queries[query], GL_QUERY_RESULT_AVAILABLE, &available);
+    if (!available)
+      break;
+    GLuint64 nanoseconds = 0;
+    glGetQueryObjectui64v(queries[query], GL_QUERY_RESULT, &nanoseconds);
+    pending[query] = false;
+    milliseconds = static_cast<float>(nanoseconds) * 1e-6f;
+    found = true;
+  }
+  return found;
+}
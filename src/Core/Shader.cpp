@@ -1,190 +1,264 @@
 #include <GenWorld/Core/Shader.h>
+#include <GenWorld/Core/GLState.h>
+#include <GenWorld/Core/UniformBuffer.h>
 #include <GenWorld/Utils/OpenGlInc.h>
-Shader::Shader(const char *vertexPath, const char *fragmentPath) {
-  // 1. retrieve the vertex/fragment source code from filePath
-  std::string vertexCode;
-  std::string fragmentCode;
-  std::ifstream vShaderFile;
-  std::ifstream fShaderFile;
+#include <algorithm>
+#include <string>
+#include <vector>
+
+namespace {
+std::string readFile(const char *path) {
+  std::ifstream file;
   // ensure ifstream objects can throw exceptions:
-  vShaderFile.exceptions(std::ifstream::failbit | std::ifstream::badbit);
-  fShaderFile.exceptions(std::ifstream::failbit | std::ifstream::badbit);
+  file.exceptions(std::ifstream::failbit | std::ifstream::badbit);
   try {
-    // open files
-    vShaderFile.open(vertexPath);
-    fShaderFile.open(fragmentPath);
-    std::stringstream vShaderStream, fShaderStream;
-    // read file's buffer contents into streams
-    vShaderStream << vShaderFile.rdbuf();
-    fShaderStream << fShaderFile.rdbuf();
-    // close file handlers
-    vShaderFile.close();
-    fShaderFile.close();
-    // convert stream into string
-    vertexCode = vShaderStream.str();
-    fragmentCode = fShaderStream.str();
-  } catch (std::ifstream::failure e) {
-    std::cout << "ERROR::SHADER::FILE_NOT_SUCCESFULLY_READ" << std::endl;
+    file.open(path);
+    std::stringstream stream;
+    stream << file.rdbuf();
+    return stream.str();
+  } catch (const std::ifstream::failure &e) {
+    std::cout << "ERROR::SHADER::FILE_NOT_SUCCESFULLY_READ: " << path
+              << std::endl;
+    return "";
   }
-  const char *vShaderCode = vertexCode.c_str();
-  const char *fShaderCode = fragmentCode.c_str();
-
-  // 2. compile shaders
-  unsigned int vertex, fragment;
+}
 
-  // vertex Shader
-  vertex = glCreateShader(GL_VERTEX_SHADER);
-  glShaderSource(vertex, 1, &vShaderCode, NULL);
-  glCompileShader(vertex);
-  // print compile errors if any
-  checkCompileErrors(vertex, "VERTEX");
+// GLSL has no #include, so a line `#include "name"` is replaced here by the
+// file of that name next to the shader. A #line after it keeps compile
+// errors on the shader's own lines. Included files are not searched again.
+std::string readSource(const char *path) {
+  std::string source = readFile(path);
+  std::string directory(path);
+  size_t slash = directory.find_last_of("/\\");
+  directory.erase(slash == std::string::npos ? 0 : slash + 1);
 
-  fragment = glCreateShader(GL_FRAGMENT_SHADER);
-  glShaderSource(fragment, 1, &fShaderCode, NULL);
-  glCompileShader(fragment);
-  // print compile errors if any
-  checkCompileErrors(fragment, "FRAGMENT");
+  const std::string directive = "#include \"";
+  std::string resolved;
+  std::istringstream lines(source);
+  std::string line;
+  for (int number = 1; std::getline(lines, line); ++number) {
+    size_t start = line.find_first_not_of(" \t");
+    bool included = start != std::string::npos &&
+                    line.compare(start, directive.size(), directive) == 0;
+    size_t end = included ? line.find('"', start + directive.size())
+                          : std::string::npos;
+    if (end == std::string::npos) {
+      resolved += line + "\n";
+      continue;
+    }
+    std::string name = line.substr(start + directive.size(),
+                                   end - start - directive.size());
+    resolved += readFile((directory + name).c_str());
+    resolved += "\n#line " + std::to_string(number + 1) + "\n";
+  }
+  return resolved;
+}
 
-  ID = glCreateProgram();
-  glAttachShader(ID, vertex);
-  glAttachShader(ID, fragment);
-  glLinkProgram(ID);
-  // print linking errors if any
-  checkCompileErrors(ID, "PROGRAM");
+// GLSL wants #version before anything else, so the defines go right after
+// it, followed by a #line that keeps compile errors on the file's own lines.
+std::string withDefines(const std::string &source,
+                        const std::vector<std::string> &defines) {
+  if (defines.empty())
+    return source;
+  size_t insert = 0;
+  size_t version = source.find("#version");
+  if (version != std::string::npos) {
+    size_t end = source.find('\n', version);
+    insert = end == std::string::npos ? source.size() : end + 1;
+  }
 
-  // delete the shaders as they're linked into our program now and no longer
-  // necessary
-  glDeleteShader(vertex);
-  glDeleteShader(fragment);
+  std::string prologue;
+  for (const std::string &define : defines)
+    prologue += "#define " + define + "\n";
+  int nextLine = 1 + static_cast<int>(std::count(
+                         source.begin(), source.begin() + insert, '\n'));
+  prologue += "#line " + std::to_string(nextLine) + "\n";
+  return std::string(source).insert(insert, prologue);
 }
+} // namespace
+
+Shader::Shader(const char *vertexPath, const char *fragmentPath)
+    : Shader(vertexPath, fragmentPath, nullptr, {}) {}
 
 Shader::Shader(const char *vertexPath, const char *fragmentPath,
-               const char *geometryPath) {
-  // 1. retrieve the vertex/fragment source code from filePath
-  std::string vertexCode;
-  std::string fragmentCode;
+               const char *geometryPath)
+    : Shader(vertexPath, fragmentPath, geometryPath, {}) {}
+
+Shader::Shader(const char *vertexPath, const char *fragmentPath,
+               const char *geometryPath,
+               const std::vector<std::string> &defines) {
+  // 1. retrieve the source code from the files
+  std::string vertexCode = withDefines(readSource(vertexPath), defines);
+  std::string fragmentCode = withDefines(readSource(fragmentPath), defines);
   std::string geometryCode;
-  std::ifstream vShaderFile;
-  std::ifstream fShaderFile;
-  std::ifstream gShaderFile;
-  // ensure ifstream objects can throw exceptions:
-  vShaderFile.exceptions(std::ifstream::failbit | std::ifstream::badbit);
-  fShaderFile.exceptions(std::ifstream::failbit | std::ifstream::badbit);
-  gShaderFile.exceptions(std::ifstream::failbit | std::ifstream::badbit);
-  try {
-    // open files
-    vShaderFile.open(vertexPath);
-    fShaderFile.open(fragmentPath);
-    gShaderFile.open(geometryPath);
-    std::stringstream vShaderStream, fShaderStream, gShaderStream;
-    // read file's buffer contents into streams
-    vShaderStream << vShaderFile.rdbuf();
-    fShaderStream << fShaderFile.rdbuf();
-    gShaderStream << gShaderFile.rdbuf();
-    // close file handlers
-    vShaderFile.close();
-    fShaderFile.close();
-    gShaderFile.close();
-    // convert stream into string
-    vertexCode = vShaderStream.str();
-    fragmentCode = fShaderStream.str();
-    geometryCode = gShaderStream.str();
-  } catch (std::ifstream::failure e) {
-    std::cout << "ERROR::SHADER::FILE_NOT_SUCCESFULLY_READ" << std::endl;
-  }
-  const char *vShaderCode = vertexCode.c_str();
-  const char *fShaderCode = fragmentCode.c_str();
-  const char *gShaderCode = geometryCode.c_str();
+  if (geometryPath != nullptr)
+    geometryCode = withDefines(readSource(geometryPath), defines);
 
   // 2. compile shaders
-  unsigned int vertex, fragment, geometry;
-
-  // vertex Shader
-  vertex = glCreateShader(GL_VERTEX_SHADER);
-  glShaderSource(vertex, 1, &vShaderCode, NULL);
-  glCompileShader(vertex);
-  // print compile errors if any
-  checkCompileErrors(vertex, "VERTEX");
-
-  // fragment Shader
-  fragment = glCreateShader(GL_FRAGMENT_SHADER);
-  glShaderSource(fragment, 1, &fShaderCode, NULL);
-  glCompileShader(fragment);
-  // print compile errors if any
-  checkCompileErrors(fragment, "FRAGMENT");
-  // geometry Shader
-  geometry = glCreateShader(GL_GEOMETRY_SHADER);
-  glShaderSource(geometry, 1, &gShaderCode, NULL);
-  glCompileShader(geometry);
-  // print compile errors if any
-  checkCompileErrors(geometry, "GEOMETRY");
+  auto compile = [this](GLenum type, const std::string &code,
+                        const char *name) {
+    const char *source = code.c_str();
+    unsigned int stage = glCreateShader(type);
+    glShaderSource(stage, 1, &source, NULL);
+    glCompileShader(stage);
+    // print compile errors if any
+    checkCompileErrors(stage, name);
+    return stage;
+  };
+  unsigned int vertex = compile(GL_VERTEX_SHADER, vertexCode, "VERTEX");
+  unsigned int fragment =
+      compile(GL_FRAGMENT_SHADER, fragmentCode, "FRAGMENT");
+  unsigned int geometry = 0;
+  if (geometryPath != nullptr)
+    geometry = compile(GL_GEOMETRY_SHADER, geometryCode, "GEOMETRY");
 
   ID = glCreateProgram();
   glAttachShader(ID, vertex);
   glAttachShader(ID, fragment);
-  glAttachShader(ID, geometry);
+  if (geometry != 0)
+    glAttachShader(ID, geometry);
   glLinkProgram(ID);
   // print linking errors if any
   checkCompileErrors(ID, "PROGRAM");
+  reflectUniforms();
 
   // delete the shaders as they're linked into our program now and no longer
   // necessary
   glDeleteShader(vertex);
   glDeleteShader(fragment);
-  glDeleteShader(geometry);
+  if (geometry != 0)
+    glDeleteShader(geometry);
 }
 
 Shader::~Shader() { glDeleteProgram(ID); }
 
-void Shader::use() { glUseProgram(ID); }
+void Shader::use() { GLState::UseProgram(ID); }
+
+void Shader::reflectUniforms() {
+  uniformLocations.clear();
+
+  GLint count = 0, maxLength = 0;
+  glGetProgramiv(ID, GL_ACTIVE_UNIFORMS, &count);
+  glGetProgramiv(ID, GL_ACTIVE_UNIFORM_MAX_LENGTH, &maxLength);
+  std::vector<char> buffer(std::max(maxLength, 1));
+  for (GLint i = 0; i < count; ++i) {
+    GLsizei length = 0;
+    GLint size = 0;
+    GLenum type = 0;
+    glGetActiveUniform(ID, i, static_cast<GLsizei>(buffer.size()), &length,
+                       &size, &type, buffer.data());
+    std::string name(buffer.data(), length);
+    GLint location = glGetUniformLocation(ID, name.c_str());
+    if (location < 0)
+      continue; // a member of a uniform block
+
+    // Arrays are reported once, as their first element
+    const std::string first = "[0]";
+    if (name.size() > first.size() &&
+        name.compare(name.size() - first.size(), first.size(), first) == 0) {
+      std::string base = name.substr(0, name.size() - first.size());
+      uniformLocations[base] = location;
+      for (GLint element = 1; element < size; ++element) {
+        std::string elementName = base + "[" + std::to_string(element) + "]";
+        uniformLocations[elementName] =
+            glGetUniformLocation(ID, elementName.c_str());
+      }
+    }
+    uniformLocations[name] = location;
+  }
+
+  // Blocks a shader declares but never reads are optimised away
+  GLuint camera = glGetUniformBlockIndex(ID, FrameUniforms::kCameraBlock);
+  if (camera != GL_INVALID_INDEX)
+    glUniformBlockBinding(ID, camera, FrameUniforms::kCameraBinding);
+  GLuint shading = glGetUniformBlockIndex(ID, FrameUniforms::kShadingBlock);
+  if (shading != GL_INVALID_INDEX)
+    glUniformBlockBinding(ID, shading, FrameUniforms::kShadingBinding);
+}
+
+int Shader::GetUniformLocation(const std::string &name) const {
+  auto it = uniformLocations.find(name);
+  return it != uniformLocations.end() ? it->second : -1;
+}
 
 void Shader::setBool(const std::string &name, bool value) const {
-  glUniform1i(glGetUniformLocation(ID, name.c_str()), (int)value);
+  setBool(GetUniformLocation(name), value);
 }
 
 void Shader::setInt(const std::string &name, int value) const {
-  glUniform1i(glGetUniformLocation(ID, name.c_str()), value);
+  setInt(GetUniformLocation(name), value);
 }
 
 void Shader::setFloat(const std::string &name, float value) const {
-  glUniform1f(glGetUniformLocation(ID, name.c_str()), value);
+  setFloat(GetUniformLocation(name), value);
 }
 
 void Shader::setMat3(const std::string &name, const glm::mat3 &mat) const {
-  glUniformMatrix3fv(glGetUniformLocation(ID, name.c_str()), 1, GL_FALSE,
-                     glm::value_ptr(mat));
+  setMat3(GetUniformLocation(name), mat);
 }
 
 void Shader::setMat4(const std::string &name, const glm::mat4 &mat) const {
-  unsigned int transformLoc = glGetUniformLocation(ID, name.c_str());
-  glUniformMatrix4fv(transformLoc, 1, GL_FALSE, glm::value_ptr(mat));
+  setMat4(GetUniformLocation(name), mat);
 }
 
 void Shader::setVec2(const std::string &name, const float x,
                      const float y) const {
-  glUniform2f(glGetUniformLocation(ID, name.c_str()), x, y);
+  setVec2(GetUniformLocation(name), glm::vec2(x, y));
 }
 
 void Shader::setVec2(const std::string &name, const glm::vec2 &value) const {
-  glUniform2fv(glGetUniformLocation(ID, name.c_str()), 1, &value[0]);
+  setVec2(GetUniformLocation(name), value);
 }
 
 void Shader::setVec3(const std::string &name, const float x, const float y,
                      const float z) const {
-  glUniform3f(glGetUniformLocation(ID, name.c_str()), x, y, z);
+  setVec3(GetUniformLocation(name), glm::vec3(x, y, z));
 }
 
 void Shader::setVec3(const std::string &name, const glm::vec3 &value) const {
-  glUniform3fv(glGetUniformLocation(ID, name.c_str()), 1, &value[0]);
+  setVec3(GetUniformLocation(name), value);
 }
 
 void Shader::setVec4(const std::string &name, const float x, const float y,
                      const float z, const float w) const {
-  glUniform4f(glGetUniformLocation(ID, name.c_str()), x, y, z, w);
+  setVec4(GetUniformLocation(name), glm::vec4(x, y, z, w));
 }
 
 void Shader::setVec4(const std::string &name, const glm::vec4 &value) const {
-  glUniform4fv(glGetUniformLocation(ID, name.c_str()), 1, &value[0]);
+  setVec4(GetUniformLocation(name), value);
+}
+
+// Location -1 is ignored by GL, so missing uniforms stay harmless
+void Shader::setBool(int location, bool value) const {
+  glUniform1i(location, (int)value);
+}
+
+void Shader::setInt(int location, int value) const {
+  glUniform1i(location, value);
+}
+
+void Shader::setFloat(int location, float value) const {
+  glUniform1f(location, value);
+}
+
+void Shader::setMat3(int location, const glm::mat3 &mat) const {
+  glUniformMatrix3fv(location, 1, GL_FALSE, glm::value_ptr(mat));
+}
+
+void Shader::setMat4(int location, const glm::mat4 &mat) const {
+  glUniformMatrix4fv(location, 1, GL_FALSE, glm::value_ptr(mat));
+}
+
+void Shader::setVec2(int location, const glm::vec2 &value) const {
+  glUniform2fv(location, 1, &value[0]);
+}
+
+void Shader::setVec3(int location, const glm::vec3 &value) const {
+  glUniform3fv(location, 1, &value[0]);
+}
+
+void Shader::setVec4(int location, const glm::vec4 &value) const {
+  glUniform4fv(location, 1, &value[0]);
 }
 
 void Shader::checkCompileErrors(unsigned int shader, std::string type) {
@@ -1,2 +1,53 @@
 #include <GenWorld/Core/ShaderManager.h>
-ShaderManager *ShaderManager::instance = nullptr;
\ No newline at end of file
+#include <algorithm>
+
+ShaderManager *ShaderManager::instance = nullptr;
+
+void ShaderManager::loadPermutableShader(const std::string &name,
+                                         const std::string &vertexPath,
+                                         const std::string &fragmentPath,
+                                         const std::string &geometryPath) {
+  if (geometryPath.empty())
+    loadShader(name, vertexPath.c_str(), fragmentPath.c_str());
+  else
+    loadShader(name, vertexPath.c_str(), fragmentPath.c_str(),
+               geometryPath.c_str());
+
+  // Permutations of a shader loaded before under this name are stale
+  for (auto it = permutable.begin(); it != permutable.end();)
+    it = it->second.name == name ? permutable.erase(it) : std::next(it);
+  for (auto it = permutations.begin(); it != permutations.end();)
+    it = it->first.compare(0, name.size() + 1, name + ";") == 0
+             ? permutations.erase(it)
+             : std::next(it);
+
+  std::shared_ptr<Shader> base = getShader(name);
+  if (base)
+    permutable[base.get()] = {base, name, vertexPath, fragmentPath,
+                              geometryPath};
+}
+
+std::shared_ptr<Shader>
+ShaderManager::getPermutation(const std::shared_ptr<Shader> &shader,
+                              std::vector<std::string> defines) {
+  auto source = permutable.find(shader.get());
+  if (defines.empty() || source == permutable.end())
+    return shader;
+
+  // The same features asked for in any order are the same permutation
+  std::sort(defines.begin(), defines.end());
+  std::string key = source->second.name;
+  for (const std::string &define : defines)
+    key += ";" + define;
+  auto cached = permutations.find(key);
+  if (cached != permutations.end())
+    return cached->second;
+
+  const PermutableShader &paths = source->second;
+  auto permutation = std::make_shared<Shader>(
+      paths.vertexPath.c_str(), paths.fragmentPath.c_str(),
+      paths.geometryPath.empty() ? nullptr : paths.geometryPath.c_str(),
+      defines);
+  permutations.emplace(key, permutation);
+  return permutation;
+}
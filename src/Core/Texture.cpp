@@ -1,4 +1,5 @@
 #include <GenWorld/Core/Texture.h>
+#include <GenWorld/Core/GLState.h>
 #include <GenWorld/Utils/Utils.h>
 #include <iostream>
 #define STB_IMAGE_IMPLEMENTATION
@@ -43,10 +44,12 @@ Texture::Texture(std::string path, TexType type) {
   unbind();
 }
 
-Texture::~Texture() { glDeleteTextures(1, &ID); }
+Texture::~Texture() { GLState::DeleteTexture(ID); }
 
-void Texture::activate(GLenum textureUnit) { glActiveTexture(textureUnit); }
+void Texture::activate(GLenum textureUnit) {
+  GLState::ActiveTexture(textureUnit);
+}
 
-void Texture::bind() { glBindTexture(GL_TEXTURE_2D, ID); }
+void Texture::bind() { GLState::BindTexture2D(ID); }
 
-void Texture::unbind() { glBindTexture(GL_TEXTURE_2D, 0); }
+void Texture::unbind() { GLState::BindTexture2D(0); }
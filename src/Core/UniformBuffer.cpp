@@ -0,0 +1,24 @@
+#include <GenWorld/Core/UniformBuffer.h>
+#include <GenWorld/Utils/OpenGlInc.h>
+
+UniformBuffer::UniformBuffer(unsigned int binding, size_t size)
+    : binding(binding), size(size) {
+  glGenBuffers(1, &ID);
+  glBindBuffer(GL_UNIFORM_BUFFER, ID);
+  glBufferData(GL_UNIFORM_BUFFER, size, nullptr, GL_DYNAMIC_DRAW);
+  glBindBuffer(GL_UNIFORM_BUFFER, 0);
+  glBindBufferBase(GL_UNIFORM_BUFFER, binding, ID);
+}
+
+UniformBuffer::~UniformBuffer() {
+  if (ID)
+    glDeleteBuffers(1, &ID);
+}
+
+void UniformBuffer::Update(const void *data, size_t size, size_t offset) {
+  if (offset + size > this->size)
+    return;
+  glBindBuffer(GL_UNIFORM_BUFFER, ID);
+  glBufferSubData(GL_UNIFORM_BUFFER, offset, size, data);
+  glBindBuffer(GL_UNIFORM_BUFFER, 0);
+}
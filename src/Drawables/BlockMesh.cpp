@@ -1,6 +1,13 @@
 #include <GenWorld/Core/ShaderManager.h>
 #include <GenWorld/Drawables/BlockMesh.h>
+#include <GenWorld/Drawables/IndirectBatch.h>
+#include <GenWorld/Drawables/InstanceCuller.h>
+#include <algorithm>
+#include <atomic>
+#include <future>
 #include <iostream>
+#include <map>
+#include <thread>
 
 BlockMesh::BlockMesh(vector<Vertex> vertices, vector<unsigned int> indices,
                      BlockUtilities::BlockData blockData,
@@ -19,11 +26,46 @@ void BlockMesh::Draw(const glm::mat4 &view, const glm::mat4 &projection) {
 
 void BlockMesh::AddBlockInstance(int blockTypeId,
                                  const Transform &blockTransform) {
-  blockInstances[blockTypeId].push_back(blockTransform.getModelMatrix());
+  *AddBlockInstances(blockTypeId, 1) = blockTransform.getModelMatrix();
 }
 
 void BlockMesh::AddBlockInstance(const std::string &assetPath,
                                  const Transform &blockTransform) {
+  if (glm::mat4 *slot = AddBlockInstances(assetPath, 1))
+    *slot = blockTransform.getModelMatrix();
+}
+
+glm::mat4 *BlockMesh::AddBlockInstances(int blockTypeId, size_t count) {
+  auto &instances = blockInstances[blockTypeId];
+  size_t first = instances.size();
+  instances.resize(first + count);
+  return instances.data() + first;
+}
+
+glm::mat4 *BlockMesh::AddBlockInstances(const std::string &assetPath,
+                                        size_t count) {
+  if (!loadAssetModel(assetPath))
+    return nullptr;
+
+  culler.reset(); // its hierarchy holds the old instance bounds
+  auto &instances = assetInstances[assetPath];
+  size_t first = instances.size();
+  instances.resize(first + count);
+  return instances.data() + first;
+}
+
+glm::mat4 *BlockMesh::AddInteriorInstances(const std::string &assetPath,
+                                           size_t count) {
+  if (!loadAssetModel(assetPath))
+    return nullptr;
+
+  auto &instances = interiorInstances[assetPath];
+  size_t first = instances.size();
+  instances.resize(first + count);
+  return instances.data() + first;
+}
+
+bool BlockMesh::loadAssetModel(const std::string &assetPath) {
   // Load model if not already loaded
   if (assetModels.find(assetPath) == assetModels.end()) {
     std::shared_ptr<Model> model = std::make_shared<Model>(assetPath.c_str());
@@ -31,11 +73,10 @@ void BlockMesh::AddBlockInstance(const std::string &assetPath,
       assetModels[assetPath] = model;
     } else {
       std::cerr << "Failed to load block model: " << assetPath << std::endl;
-      return;
+      return false;
     }
   }
-
-  assetInstances[assetPath].push_back(blockTransform.getModelMatrix());
+  return true;
 }
 
 glm::vec3 BlockMesh::GetBlockPosition(int gridX, int gridZ) const {
@@ -56,17 +97,174 @@ bool BlockMesh::IsValidGridPosition(int gridX, int gridZ) const {
 
 void BlockMesh::DrawBlockInstances(const glm::mat4 &view,
                                    const glm::mat4 &projection) {
+  if (!staticBatches.empty()) {
+    for (auto &batch : staticBatches) {
+      batch->SetShaderParameters(m_currentShadingParams);
+      batch->Draw(view, projection);
+    }
+    return;
+  }
+
+  // Built on the first draw, once generation has filled the instances
+  if (!culler)
+    culler = std::make_unique<InstanceCuller>(instanceSources());
+  culler->Cull(view, projection);
+  const auto &visible = culler->Visible();
+
+  if (indirectBatch) {
+    // The materials come from the models' meshes, which pick their shader
+    // from the shading parameters
+    for (auto &pair : assetModels)
+      if (pair.second)
+        pair.second->SetShaderParameters(m_currentShadingParams);
+    indirectBatch->SetInstances(visible);
+    indirectBatch->Draw();
+    return;
+  }
+
+  for (size_t list = 0; list < visible.size(); ++list) {
+    if (visible[list]->empty())
+      continue;
+    Model *model = culler->Sources()[culler->ListSource(list)].first;
+    model->SetShaderParameters(m_currentShadingParams);
+    model->DrawInstanced(view, projection, *visible[list],
+                         culler->ListLevel(list));
+  }
+}
+
+std::vector<IndirectBatch::Source> BlockMesh::instanceSources() {
+  std::vector<IndirectBatch::Source> sources;
   for (const auto &pair : assetInstances) {
-    const std::string &assetPath = pair.first;
-    const std::vector<glm::mat4> &instances = pair.second;
+    auto modelIt = assetModels.find(pair.first);
+    if (!pair.second.empty() && modelIt != assetModels.end() &&
+        modelIt->second)
+      sources.emplace_back(modelIt->second.get(), &pair.second);
+  }
+  return sources;
+}
 
-    if (instances.empty())
+void BlockMesh::BakeStaticBatches(size_t maxBatchVertices) {
+  staticBatches.clear();
+  maxBatchVertices = std::max<size_t>(1, maxBatchVertices);
+
+  // Submeshes of every drawn model are grouped by their texture set, so
+  // blocks of different models that share a material end up together
+  using Source = std::pair<const Mesh *, const std::vector<glm::mat4> *>;
+  std::map<std::vector<Texture *>, std::vector<Source>> groups;
+  for (const auto &pair : assetInstances) {
+    auto modelIt = assetModels.find(pair.first);
+    if (pair.second.empty() || modelIt == assetModels.end() ||
+        !modelIt->second)
       continue;
+    for (const Mesh *mesh : modelIt->second->getMeshes()) {
+      if (!mesh || mesh->vertices.empty() || mesh->indices.empty())
+        continue;
+      std::vector<Texture *> material;
+      for (const auto &texture : mesh->textures)
+        material.push_back(texture.get());
+      groups[material].emplace_back(mesh, &pair.second);
+    }
+  }
 
-    std::shared_ptr<Model> model = assetModels[assetPath];
-    if (model) {
-      model->SetShaderParameters(m_currentShadingParams);
-      model->DrawInstanced(view, projection, instances);
+  // Each group is cut into batches of at most maxBatchVertices; a single
+  // submesh larger than that gets a batch of its own
+  struct Run {
+    const Mesh *source;
+    const glm::mat4 *matrices;
+    size_t count;
+  };
+  struct Batch {
+    const std::vector<std::shared_ptr<Texture>> *textures;
+    std::vector<Run> runs;
+    size_t vertexCount = 0, indexCount = 0;
+    std::vector<Vertex> vertices;
+    std::vector<unsigned int> indices;
+  };
+  std::vector<Batch> batches;
+  for (const auto &group : groups) {
+    size_t open = batches.size();
+    for (const auto &[mesh, instances] : group.second) {
+      size_t size = mesh->vertices.size();
+      for (size_t i = 0; i < instances->size(); ++i) {
+        if (open == batches.size() ||
+            (batches[open].vertexCount > 0 &&
+             batches[open].vertexCount + size > maxBatchVertices)) {
+          open = batches.size();
+          batches.emplace_back();
+          batches[open].textures = &mesh->textures;
+        }
+        Batch &batch = batches[open];
+        if (!batch.runs.empty() && batch.runs.back().source == mesh)
+          batch.runs.back().count++;
+        else
+          batch.runs.push_back({mesh, &(*instances)[i], 1});
+        batch.vertexCount += size;
+        batch.indexCount += mesh->indices.size();
+      }
+    }
+  }
+
+  // Pre-transforming is the slow part and touches no GL state, so it runs
+  // on every core; only the uploads below need the context thread
+  auto direction = [](const glm::mat3 &basis, const glm::vec3 &v) {
+    glm::vec3 result = basis * v;
+    float length = glm::length(result);
+    return length > 0.0f ? result / length : result;
+  };
+  auto fill = [&](Batch &batch) {
+    batch.vertices.reserve(batch.vertexCount);
+    batch.indices.reserve(batch.indexCount);
+    for (const Run &run : batch.runs) {
+      for (size_t k = 0; k < run.count; ++k) {
+        const glm::mat4 &matrix = run.matrices[k];
+        glm::mat3 basis(matrix);
+        glm::mat3 normalBasis = glm::transpose(glm::inverse(basis));
+        auto base = static_cast<unsigned int>(batch.vertices.size());
+        for (Vertex vertex : run.source->vertices) {
+          vertex.Position =
+              glm::vec3(matrix * glm::vec4(vertex.Position, 1.0f));
+          vertex.Normal = direction(normalBasis, vertex.Normal);
+          vertex.Tangent = direction(basis, vertex.Tangent);
+          vertex.Bitangent = direction(basis, vertex.Bitangent);
+          batch.vertices.push_back(vertex);
+        }
+        for (unsigned int index : run.source->indices)
+          batch.indices.push_back(base + index);
+      }
     }
+  };
+  std::atomic<size_t> next{0};
+  auto worker = [&] {
+    size_t i;
+    while ((i = next++) < batches.size())
+      fill(batches[i]);
+  };
+  size_t threads = std::max(1u, std::thread::hardware_concurrency());
+  std::vector<std::future<void>> workers;
+  for (size_t t = 0; t < std::min(threads, batches.size()); ++t)
+    workers.push_back(std::async(std::launch::async, worker));
+  for (auto &task : workers)
+    task.get();
+
+  for (Batch &batch : batches)
+    staticBatches.push_back(std::make_unique<Mesh>(
+        std::move(batch.vertices), std::move(batch.indices), *batch.textures));
+  std::cout << "Baked " << assetInstances.size() << " block models into "
+            << staticBatches.size() << " static batches" << std::endl;
+}
+
+void BlockMesh::BuildIndirectBatch() {
+  indirectBatch.reset();
+  if (!IndirectBatch::IsSupported()) {
+    std::cout << "Multi-draw indirect needs OpenGL 4.3; drawing instanced"
+              << std::endl;
+    return;
   }
+
+  // Indexed like the culler's sources, which take the same list
+  std::vector<IndirectBatch::Source> sources = instanceSources();
+  indirectBatch = std::make_unique<IndirectBatch>(sources);
+  std::cout << "Packed " << sources.size() << " block models into "
+            << indirectBatch->CommandCount() << " indirect draws over "
+            << indirectBatch->GroupCount() << " materials" << std::endl;
 }
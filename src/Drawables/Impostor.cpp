@@ -0,0 +1,227 @@
+#include <GenWorld/Core/FrameBuffer.h>
+#include <GenWorld/Core/GLState.h>
+#include <GenWorld/Core/ShaderManager.h>
+#include <GenWorld/Core/stb_image.h>
+#include <GenWorld/Core/stb_image_write.h>
+#include <GenWorld/Drawables/Impostor.h>
+#include <GenWorld/Drawables/Model.h>
+#include <GenWorld/Utils/OpenGlInc.h>
+#include <GenWorld/Utils/Profiler.h>
+#include <glm/gtc/constants.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+#include <cmath>
+#include <filesystem>
+#include <functional>
+#include <iostream>
+
+namespace fs = std::filesystem;
+
+Impostor::Impostor(Model &model, const std::string &modelPath) {
+  Utils::Profiler::Scope scope("Impostor");
+  const Bounds &bounds = model.GetBounds();
+  if (bounds.IsEmpty())
+    return;
+  center = bounds.Center();
+  radius = bounds.Radius();
+
+  std::string path = cachePath(modelPath);
+  if (!loadCached(path, modelPath)) {
+    // Without an atlas the impostor is never ready, and the model draws at
+    // every distance instead
+    std::vector<unsigned char> pixels;
+    if (!bake(model, pixels))
+      return;
+    upload(pixels.data(), kViews * kTileSize, 2 * kTileSize);
+    writeCache(path, pixels);
+  }
+  setupQuad();
+}
+
+Impostor::~Impostor() {
+  GLState::DeleteTexture(atlas);
+  GLState::DeleteVertexArray(arrayObj);
+  glDeleteBuffers(1, &quadBuffer);
+  glDeleteBuffers(1, &instanceBuffer);
+}
+
+std::string Impostor::cachePath(const std::string &modelPath) const {
+  // The file name alone can repeat across asset folders, so the full path
+  // is hashed into it. The atlas format is named too, so atlases baked by
+  // another layout or bake shader are never loaded.
+  size_t hash = std::hash<std::string>{}(modelPath);
+  return std::string(kCacheDirectory) + "/" +
+         fs::path(modelPath).stem().string() + "_" + std::to_string(hash) +
+         "_v" + std::to_string(kCacheVersion) + "_" + std::to_string(kViews) +
+         "x" + std::to_string(kTileSize) + ".png";
+}
+
+void Impostor::writeCache(const std::string &path,
+                          const std::vector<unsigned char> &pixels) const {
+  // The atlas is already uploaded, so a failure only costs a bake next run
+  std::error_code error;
+  fs::create_directories(kCacheDirectory, error);
+  if (error) {
+    std::cerr << "Failed to create " << kCacheDirectory << ": "
+              << error.message() << std::endl;
+    return;
+  }
+  if (!stbi_write_png(path.c_str(), kViews * kTileSize, 2 * kTileSize, 4,
+                      pixels.data(), kViews * kTileSize * 4)) {
+    std::cerr << "Failed to cache impostor " << path << std::endl;
+    // Leave no partly written atlas behind
+    fs::remove(path, error);
+  }
+}
+
+bool Impostor::loadCached(const std::string &path,
+                          const std::string &modelPath) {
+  // An atlas older than its model is stale
+  std::error_code error;
+  auto cached = fs::last_write_time(path, error);
+  if (error)
+    return false;
+  auto source = fs::last_write_time(modelPath, error);
+  if (!error && cached < source)
+    return false;
+
+  int width = 0, height = 0, channels = 0;
+  unsigned char *pixels = stbi_load(path.c_str(), &width, &height, &channels,
+                                    STBI_rgb_alpha);
+  bool valid = pixels && width == kViews * kTileSize &&
+               height == 2 * kTileSize;
+  if (valid)
+    upload(pixels, width, height);
+  stbi_image_free(pixels);
+  return valid;
+}
+
+bool Impostor::bake(Model &model, std::vector<unsigned char> &pixels) {
+  auto shader = ShaderManager::GetInstance()->getShader("impostorBake");
+  if (!shader)
+    return false;
+  const int width = kViews * kTileSize, height = 2 * kTileSize;
+  pixels.resize(static_cast<size_t>(width) * height * 4);
+
+  // Baking happens mid-frame, inside whatever target the renderer is
+  // drawing to, so that target is put back afterwards
+  GLint previousFramebuffer = 0, viewport[4];
+  GLfloat clearColor[4];
+  glGetIntegerv(GL_DRAW_FRAMEBUFFER_BINDING, &previousFramebuffer);
+  glGetIntegerv(GL_VIEWPORT, viewport);
+  glGetFloatv(GL_COLOR_CLEAR_VALUE, clearColor);
+  GLboolean depthTest = glIsEnabled(GL_DEPTH_TEST);
+
+  FrameBuffer target;
+  target.Resize(width, height);
+  target.bind();
+  glEnable(GL_DEPTH_TEST);
+  glClearColor(0.0f, 0.0f, 0.0f, 0.0f);
+  glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+  shader->use();
+  shader->setInt("diffuse1", 0);
+  // Orthographic views from the side, looking at the model's centre, so a
+  // tile maps onto a square quad of twice the tile radius
+  float extent = tileRadius();
+  glm::mat4 projection = glm::ortho(-extent, extent, -extent, extent,
+                                    0.5f * radius, 3.5f * radius);
+  for (int row = 0; row < 2; ++row) {
+    shader->setBool("uOutputNormal", row == 1);
+    for (int view = 0; view < kViews; ++view) {
+      float angle = glm::two_pi<float>() * view / kViews;
+      glm::vec3 direction(std::sin(angle), 0.0f, std::cos(angle));
+      glm::mat4 camera = glm::lookAt(center + 2.0f * radius * direction,
+                                     center, glm::vec3(0.0f, 1.0f, 0.0f));
+      shader->setMat4("uViewProjection", projection * camera);
+      glViewport(view * kTileSize, row * kTileSize, kTileSize, kTileSize);
+
+      for (Mesh *mesh : model.getMeshes()) {
+        std::shared_ptr<Texture> diffuse;
+        for (const auto &texture : mesh->textures)
+          if (texture->type == TexType::diffuse) {
+            diffuse = texture;
+            break;
+          }
+        shader->setBool("uHasTexture", diffuse != nullptr);
+        if (diffuse) {
+          Texture::activate(GL_TEXTURE0);
+          diffuse->bind();
+        }
+        mesh->DrawGeometry();
+      }
+    }
+  }
+  glReadPixels(0, 0, width, height, GL_RGBA, GL_UNSIGNED_BYTE, pixels.data());
+
+  glBindFramebuffer(GL_FRAMEBUFFER, previousFramebuffer);
+  glViewport(viewport[0], viewport[1], viewport[2], viewport[3]);
+  glClearColor(clearColor[0], clearColor[1], clearColor[2], clearColor[3]);
+  if (!depthTest)
+    glDisable(GL_DEPTH_TEST);
+  target.Destroy();
+  return true;
+}
+
+// The rows are kept in the order glReadPixels returns them, bottom first,
+// both in the texture and in the cached file.
+void Impostor::upload(const unsigned char *pixels, int width, int height) {
+  glGenTextures(1, &atlas);
+  GLState::BindTexture2D(atlas);
+  glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, width, height, 0, GL_RGBA,
+               GL_UNSIGNED_BYTE, pixels);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER,
+                  GL_LINEAR_MIPMAP_LINEAR);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+  glGenerateMipmap(GL_TEXTURE_2D);
+}
+
+void Impostor::setupQuad() {
+  const float corners[] = {-1.0f, -1.0f, 1.0f, -1.0f,
+                           -1.0f, 1.0f,  1.0f, 1.0f};
+  glGenVertexArrays(1, &arrayObj);
+  glGenBuffers(1, &quadBuffer);
+  glGenBuffers(1, &instanceBuffer);
+  GLState::BindVertexArray(arrayObj);
+
+  glBindBuffer(GL_ARRAY_BUFFER, quadBuffer);
+  glBufferData(GL_ARRAY_BUFFER, sizeof(corners), corners, GL_STATIC_DRAW);
+  glEnableVertexAttribArray(0);
+  glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 2 * sizeof(float),
+                        (void *)0);
+
+  glBindBuffer(GL_ARRAY_BUFFER, instanceBuffer);
+  Mesh::ConfigureInstanceAttributes();
+  GLState::BindVertexArray(0);
+}
+
+void Impostor::Draw(const std::vector<glm::mat4> &instances, float fadeInner,
+                    float fadeOuter, bool lit) {
+  ShaderManager *shaders = ShaderManager::GetInstance();
+  auto shader = shaders->getShader("impostor");
+  if (!IsReady() || instances.empty() || !shader)
+    return;
+  if (lit)
+    shader = shaders->getPermutation(shader, {"USE_LIGHTS"});
+
+  // The visible set changes every frame, so the buffer is orphaned rather
+  // than waited on
+  glBindBuffer(GL_ARRAY_BUFFER, instanceBuffer);
+  glBufferData(GL_ARRAY_BUFFER, instances.size() * sizeof(glm::mat4),
+               instances.data(), GL_STREAM_DRAW);
+
+  shader->use();
+  shader->setVec3("uCenter", center);
+  shader->setFloat("uRadius", tileRadius());
+  shader->setFloat("uBoundsRadius", radius);
+  shader->setInt("uViews", kViews);
+  shader->setFloat("uFadeInner", fadeInner);
+  shader->setFloat("uFadeOuter", fadeOuter);
+  shader->setInt("atlas", 0);
+  Texture::activate(GL_TEXTURE0);
+  GLState::BindTexture2D(atlas);
+  GLState::BindVertexArray(arrayObj);
+  glDrawArraysInstanced(GL_TRIANGLE_STRIP, 0, 4,
+                        static_cast<GLsizei>(instances.size()));
+}
@@ -0,0 +1,159 @@
+#include <GenWorld/Core/GLState.h>
+#include <GenWorld/Drawables/IndirectBatch.h>
+#include <GenWorld/Drawables/Model.h>
+#include <GenWorld/Utils/OpenGlInc.h>
+#include <map>
+
+bool IndirectBatch::IsSupported() { return GLAD_GL_VERSION_4_3 != 0; }
+
+int IndirectBatch::LevelCount(const Source &source) {
+  return source.first ? source.first->GetLodCount() : 1;
+}
+
+IndirectBatch::IndirectBatch(const std::vector<Source> &sources) {
+  std::vector<Vertex> vertices;
+  std::vector<unsigned int> indices;
+  std::vector<glm::mat4> instances;
+
+  // Every submesh of every level becomes one command, filed under its
+  // texture set. Only the finest level starts with instances, from its
+  // model's first matrix; a mesh shared by two levels is stored once
+  using Entry = std::pair<size_t, Command>; // list, command
+  std::map<std::vector<Texture *>, std::vector<Entry>> byMaterial;
+  std::map<std::vector<Texture *>, Mesh *> materials;
+  std::map<const Mesh *, Command> stored;
+  for (const Source &source : sources) {
+    const auto &[model, matrices] = source;
+    size_t firstList = listCommands.size();
+    listCommands.resize(firstList + LevelCount(source));
+    if (!model || !matrices || matrices->empty())
+      continue;
+    auto baseInstance = static_cast<GLuint>(instances.size());
+    instances.insert(instances.end(), matrices->begin(), matrices->end());
+
+    for (int level = 0; level < LevelCount(source); ++level) {
+      for (Mesh *mesh : model->GetLodMeshes(level)) {
+        if (!mesh || mesh->vertices.empty() || mesh->indices.empty())
+          continue;
+        std::vector<Texture *> material;
+        for (const auto &texture : mesh->textures)
+          material.push_back(texture.get());
+        materials.emplace(material, mesh);
+
+        auto [it, added] = stored.emplace(mesh, Command{});
+        Command &command = it->second;
+        if (added) {
+          command.count = static_cast<GLuint>(mesh->indices.size());
+          command.firstIndex = static_cast<GLuint>(indices.size());
+          command.baseVertex = static_cast<GLint>(vertices.size());
+          vertices.insert(vertices.end(), mesh->vertices.begin(),
+                          mesh->vertices.end());
+          indices.insert(indices.end(), mesh->indices.begin(),
+                         mesh->indices.end());
+        }
+        Command drawn = command;
+        drawn.instanceCount =
+            level == 0 ? static_cast<GLuint>(matrices->size()) : 0;
+        drawn.baseInstance = baseInstance;
+        byMaterial[material].emplace_back(firstList + level, drawn);
+      }
+    }
+  }
+  if (byMaterial.empty())
+    return;
+
+  for (auto &[material, group] : byMaterial) {
+    groups.push_back({materials[material], commands.size(), group.size()});
+    for (const auto &[list, command] : group) {
+      listCommands[list].push_back(commands.size());
+      commands.push_back(command);
+    }
+  }
+
+  glGenVertexArrays(1, &arrayObj);
+  glGenBuffers(1, &vertexBuffer);
+  glGenBuffers(1, &indexBuffer);
+  glGenBuffers(1, &instanceBuffer);
+  glGenBuffers(1, &commandBuffer);
+
+  GLState::BindVertexArray(arrayObj);
+  glBindBuffer(GL_ARRAY_BUFFER, vertexBuffer);
+  glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(Vertex),
+               vertices.data(), GL_STATIC_DRAW);
+  Mesh::ConfigureVertexAttributes();
+  glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, indexBuffer);
+  glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(unsigned int),
+               indices.data(), GL_STATIC_DRAW);
+  glBindBuffer(GL_ARRAY_BUFFER, instanceBuffer);
+  Mesh::ConfigureInstanceAttributes();
+  glBindBuffer(GL_ARRAY_BUFFER, 0);
+  GLState::BindVertexArray(0);
+
+  uploadInstances(instances);
+}
+
+void IndirectBatch::SetInstances(
+    const std::vector<const std::vector<glm::mat4> *> &lists) {
+  if (groups.empty())
+    return;
+  instanceScratch.clear();
+  for (size_t l = 0; l < lists.size() && l < listCommands.size(); ++l) {
+    const std::vector<glm::mat4> *list = lists[l];
+    auto first = static_cast<GLuint>(instanceScratch.size());
+    auto count = static_cast<GLuint>(list ? list->size() : 0);
+    if (count > 0)
+      instanceScratch.insert(instanceScratch.end(), list->begin(),
+                             list->end());
+    for (size_t c : listCommands[l]) {
+      commands[c].baseInstance = first;
+      commands[c].instanceCount = count;
+    }
+  }
+  uploadInstances(instanceScratch);
+}
+
+// Both buffers are respecified whole, so the driver can hand out fresh
+// storage instead of waiting on draws still reading the old contents.
+void IndirectBatch::uploadInstances(const std::vector<glm::mat4> &instances) {
+  glBindBuffer(GL_ARRAY_BUFFER, instanceBuffer);
+  glBufferData(GL_ARRAY_BUFFER, instances.size() * sizeof(glm::mat4),
+               instances.data(), GL_DYNAMIC_DRAW);
+  glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+  glBindBuffer(GL_DRAW_INDIRECT_BUFFER, commandBuffer);
+  glBufferData(GL_DRAW_INDIRECT_BUFFER, commands.size() * sizeof(Command),
+               commands.data(), GL_DYNAMIC_DRAW);
+  glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+}
+
+IndirectBatch::~IndirectBatch() {
+  GLState::DeleteVertexArray(arrayObj);
+  if (vertexBuffer)
+    glDeleteBuffers(1, &vertexBuffer);
+  if (indexBuffer)
+    glDeleteBuffers(1, &indexBuffer);
+  if (instanceBuffer)
+    glDeleteBuffers(1, &instanceBuffer);
+  if (commandBuffer)
+    glDeleteBuffers(1, &commandBuffer);
+}
+
+void IndirectBatch::Draw() {
+  if (groups.empty())
+    return;
+
+  // The indirect binding is not part of the vertex array, so it is set for
+  // the whole batch and cleared again for whoever draws next
+  glBindBuffer(GL_DRAW_INDIRECT_BUFFER, commandBuffer);
+  for (const Group &group : groups) {
+    if (!group.material->BindMaterial())
+      continue;
+    GLState::BindVertexArray(arrayObj);
+    glMultiDrawElementsIndirect(
+        GL_TRIANGLES, GL_UNSIGNED_INT,
+        reinterpret_cast<const void *>(group.firstCommand *
+                                       sizeof(Command)),
+        static_cast<GLsizei>(group.commandCount), 0);
+  }
+  glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+}
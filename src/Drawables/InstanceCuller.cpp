@@ -0,0 +1,188 @@
+#include <GenWorld/Drawables/InstanceCuller.h>
+#include <GenWorld/Drawables/Model.h>
+#include <GenWorld/Utils/Profiler.h>
+#include <algorithm>
+#include <numeric>
+
+InstanceCuller::InstanceCuller(const std::vector<Source> &sources)
+    : sources(sources) {
+  for (size_t s = 0; s < sources.size(); ++s) {
+    firstList.push_back(listSource.size());
+    for (int level = 0; level < IndirectBatch::LevelCount(sources[s]);
+         ++level) {
+      listSource.push_back(s);
+      listLevel.push_back(level);
+    }
+  }
+  firstList.push_back(listSource.size());
+  visible.resize(listSource.size());
+  for (const auto &list : visible)
+    visibleLists.push_back(&list);
+  impostorEnabled.assign(sources.size(), 0);
+  impostors.resize(sources.size());
+
+  // A sphere per instance around its model's box in world space
+  std::vector<glm::vec4> spheres;
+  std::vector<float> modelRadii;
+  std::vector<uint32_t> sourceIds, indices;
+  for (uint32_t s = 0; s < sources.size(); ++s) {
+    const auto &[model, transforms] = sources[s];
+    if (!model || !transforms || model->GetBounds().IsEmpty())
+      continue;
+    const Bounds &local = model->GetBounds();
+    for (uint32_t i = 0; i < transforms->size(); ++i) {
+      Bounds world = local.Transformed((*transforms)[i]);
+      spheres.emplace_back(world.Center(), world.Radius());
+      modelRadii.push_back(local.Radius() *
+                           glm::length(glm::vec3((*transforms)[i][0])));
+      sourceIds.push_back(s);
+      indices.push_back(i);
+    }
+  }
+  if (spheres.empty())
+    return;
+
+  std::vector<uint32_t> order(spheres.size());
+  std::iota(order.begin(), order.end(), 0u);
+  nodes.reserve(2 * spheres.size() / kLeafSize + 1);
+  build(order, 0, static_cast<uint32_t>(order.size()), spheres);
+
+  for (uint32_t k : order) {
+    centerX.push_back(spheres[k].x);
+    centerY.push_back(spheres[k].y);
+    centerZ.push_back(spheres[k].z);
+    radius.push_back(spheres[k].w);
+    modelRadius.push_back(modelRadii[k]);
+    sourceOf.push_back(sourceIds[k]);
+    indexOf.push_back(indices[k]);
+  }
+}
+
+uint32_t InstanceCuller::build(std::vector<uint32_t> &order, uint32_t first,
+                               uint32_t count,
+                               const std::vector<glm::vec4> &spheres) {
+  Bounds box, centers;
+  for (uint32_t k = first; k < first + count; ++k) {
+    const glm::vec4 &sphere = spheres[order[k]];
+    glm::vec3 center(sphere);
+    box.Add(center - glm::vec3(sphere.w));
+    box.Add(center + glm::vec3(sphere.w));
+    centers.Add(center);
+  }
+  auto self = static_cast<uint32_t>(nodes.size());
+  nodes.push_back({box, first, count, 0});
+  if (count <= kLeafSize)
+    return self;
+
+  // Median split on the axis the centres spread furthest along, which
+  // keeps the tree balanced however the instances cluster
+  glm::vec3 spread = centers.max - centers.min;
+  int axis = spread.x >= spread.y && spread.x >= spread.z ? 0
+             : spread.y >= spread.z                       ? 1
+                                                          : 2;
+  uint32_t middle = first + count / 2;
+  std::nth_element(order.begin() + first, order.begin() + middle,
+                   order.begin() + first + count,
+                   [&](uint32_t a, uint32_t b) {
+                     return spheres[a][axis] < spheres[b][axis];
+                   });
+  build(order, first, middle - first, spheres);
+  uint32_t right = build(order, middle, first + count - middle, spheres);
+  nodes[self].right = right;
+  return self;
+}
+
+void InstanceCuller::EnableImpostor(size_t source) {
+  if (source < impostorEnabled.size())
+    impostorEnabled[source] = 1;
+}
+
+void InstanceCuller::Cull(const glm::mat4 &view,
+                          const glm::mat4 &projection) {
+  Utils::Profiler::Scope scope("Cull Instances");
+  for (auto &list : visible)
+    list.clear();
+  for (auto &list : impostors)
+    list.clear();
+  visibleCount = 0;
+  if (nodes.empty())
+    return;
+
+  Frustum frustum(projection * view);
+  // The view matrix is a rotation and a translation, so the camera sits at
+  // minus the translation turned back by the transposed rotation
+  glm::mat3 rotation(view);
+  eye = -(glm::transpose(rotation) * glm::vec3(view[3]));
+  lodScale = projection[1][1]; // 1 / tan(fovY / 2)
+
+  // Median splits keep the depth near log2(instances / kLeafSize)
+  uint32_t stack[64];
+  int top = 0;
+  stack[top++] = 0;
+  while (top > 0) {
+    uint32_t index = stack[--top];
+    const Node &node = nodes[index];
+    switch (frustum.TestBox(node.box)) {
+    case Frustum::kOutside:
+      break;
+    case Frustum::kInside:
+      addRange(node.first, node.count);
+      break;
+    case Frustum::kIntersects:
+      if (node.right == 0) {
+        testLeaf(node, frustum);
+      } else {
+        stack[top++] = node.right;
+        stack[top++] = index + 1;
+      }
+      break;
+    }
+  }
+}
+
+void InstanceCuller::addRange(uint32_t first, uint32_t count) {
+  for (uint32_t k = first; k < first + count; ++k) {
+    uint32_t source = sourceOf[k];
+    int levels = static_cast<int>(firstList[source + 1] - firstList[source]);
+    bool impostor = impostorsActive && impostorEnabled[source];
+    const glm::mat4 &transform = (*sources[source].second)[indexOf[k]];
+    int level = 0;
+    if (levels > 1 || impostor) {
+      float distance =
+          glm::length(glm::vec3(centerX[k], centerY[k], centerZ[k]) - eye);
+      float coverage = radius[k] * lodScale / std::max(distance, radius[k]);
+      while (level + 1 < levels && coverage < kLodCoverage[level])
+        ++level;
+      if (impostor) {
+        float size = modelRadius[k] * lodScale /
+                     std::max(distance, modelRadius[k]);
+        if (size < kImpostorCoverage * kImpostorFade)
+          impostors[source].push_back(transform);
+        if (size < kImpostorCoverage)
+          continue;
+      }
+    }
+    visible[firstList[source] + level].push_back(transform);
+  }
+  visibleCount += count;
+}
+
+void InstanceCuller::testLeaf(const Node &leaf, const Frustum &frustum) {
+  // Branch-free over the leaf, one plane at a time, so the compiler can
+  // run each pass over several spheres at once
+  const float *x = centerX.data() + leaf.first;
+  const float *y = centerY.data() + leaf.first;
+  const float *z = centerZ.data() + leaf.first;
+  const float *r = radius.data() + leaf.first;
+  uint8_t keep[kLeafSize];
+  for (uint32_t k = 0; k < kLeafSize; ++k)
+    keep[k] = 1;
+  for (const glm::vec4 &plane : frustum.Planes())
+    for (uint32_t k = 0; k < leaf.count; ++k)
+      keep[k] &= plane.x * x[k] + plane.y * y[k] + plane.z * z[k] + plane.w >=
+                 -r[k];
+
+  for (uint32_t k = 0; k < leaf.count; ++k)
+    if (keep[k])
+      addRange(leaf.first + k, 1);
+}
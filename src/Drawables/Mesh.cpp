@@ -1,4 +1,7 @@
 #include <GenWorld/Drawables/Mesh.h>
+#include <GenWorld/Core/GLState.h>
+#include <GenWorld/Core/ShaderManager.h>
+#include <GenWorld/Renderers/DrawQueue.h>
 
 Mesh::Mesh(vector<Vertex> vertices, vector<unsigned int> indices,
            vector<std::shared_ptr<Texture>> textures)
@@ -17,7 +20,7 @@ Mesh::~Mesh() {
   if (indexBuffer)
     glDeleteBuffers(1, &indexBuffer);
   if (arrayObj)
-    glDeleteVertexArrays(1, &arrayObj);
+    GLState::DeleteVertexArray(arrayObj);
   if (instancingInitialized)
     glDeleteBuffers(1, &instanceVBO);
 
@@ -26,50 +29,84 @@ Mesh::~Mesh() {
   arrayObj = 0;
 }
 
+// Bindings are left in place after a draw; the next one only changes what
+// differs, which the renderer's state-sorted queue keeps to a minimum.
 void Mesh::Draw(Shader &shader) {
   bindTextures(shader);
-  glBindVertexArray(arrayObj);
+  DrawGeometry();
+}
+
+void Mesh::DrawGeometry() {
+  GLState::BindVertexArray(arrayObj);
   glDrawElements(GL_TRIANGLES, static_cast<unsigned int>(indices.size()),
                  GL_UNSIGNED_INT, 0);
-  glBindVertexArray(0);
-  unbindTextures();
 }
 
+// View, projection and the viewport shading parameters come from the
+// renderer's per-frame uniform blocks; a draw only sets its model matrix and
+// samplers.
 void Mesh::Draw(const glm::mat4 &view, const glm::mat4 &projection) {
-  if (m_shader != nullptr) {
-    m_shader->use();
-
-    glm::mat4 model = transform.getModelMatrix();
-    m_shader->setMat4("uModel", model);
-    m_shader->setMat4("uView", view);
-    m_shader->setMat4("uProjection", projection);
-
-    // viewport shading uniforms
-    applyShadingUniforms();
-
-    Draw(*m_shader);
-  }
+  if (m_shader != nullptr)
+    enqueue(0);
 }
 
 void Mesh::DrawInstanced(unsigned int instanceCount, const glm::mat4 &view,
                          const glm::mat4 &projection) {
-  m_shader->use();
+  if (m_shader != nullptr && instanceCount > 0)
+    enqueue(instanceCount);
+}
 
-  m_shader->setMat4("uModel", glm::mat4(1.0f));
-  m_shader->setMat4("uView", view);
-  m_shader->setMat4("uProjection", projection);
+void Mesh::enqueue(unsigned int instanceCount) {
+  DrawQueue *queue = DrawQueue::Active();
+  if (queue == nullptr) {
+    Submit(instanceCount);
+    return;
+  }
+  unsigned int textureKey = textures.empty() ? 0 : textures[0]->ID;
+  queue->Push({activeShader().ID, textureKey, arrayObj, this, instanceCount});
+  queued = true;
+}
 
-  // viewport shading uniforms
-  applyShadingUniforms();
+void Mesh::Submit(unsigned int instanceCount) {
+  queued = false;
+  if (instanceCount > 0) {
+    BindMaterial();
+    GLState::BindVertexArray(arrayObj);
+    glDrawElementsInstanced(GL_TRIANGLES, indices.size(), GL_UNSIGNED_INT, 0,
+                            instanceCount);
+    return;
+  }
 
-  bindTextures(*m_shader);
+  Shader &shader = activeShader();
+  shader.use();
+  cacheUniformLocations(shader);
+  shader.setMat4(modelLocation, transform.getModelMatrix());
+  Draw(shader);
+}
 
-  glBindVertexArray(arrayObj);
-  glDrawElementsInstanced(GL_TRIANGLES, indices.size(), GL_UNSIGNED_INT, 0,
-                          instanceCount);
-  glBindVertexArray(0);
+// The viewport features that change what a fragment computes. Everything
+// else about the viewport shading stays in the renderer's uniform block.
+void Mesh::shaderDefines(std::vector<std::string> &defines) const {
+  const ShadingParameters &params = m_currentShadingParams;
+  if (params.mode == ViewportShadingMode::RenderedWithLights)
+    defines.push_back("USE_LIGHTS");
+  if (params.mode == ViewportShadingMode::Wireframe &&
+      params.useFilledWireframe)
+    defines.push_back("USE_FILL");
+}
 
-  unbindTextures();
+Shader &Mesh::activeShader() {
+  // Asked for on every draw, so the manager is only consulted when the
+  // shader or its features change
+  defineScratch.clear();
+  shaderDefines(defineScratch);
+  if (permutationBase != m_shader || defineScratch != permutationDefines) {
+    permutation =
+        ShaderManager::GetInstance()->getPermutation(m_shader, defineScratch);
+    permutationBase = m_shader;
+    permutationDefines.swap(defineScratch);
+  }
+  return *permutation;
 }
 
 void Mesh::setupMesh() {
@@ -83,7 +120,7 @@ void Mesh::setupMesh() {
   glGenBuffers(1, &indexBuffer);
   glGenBuffers(1, &instanceVBO);
 
-  glBindVertexArray(arrayObj);
+  GLState::BindVertexArray(arrayObj);
   // load data into vertex buffers
   glBindBuffer(GL_ARRAY_BUFFER, vertexBuffer);
   // A great thing about structs is that their memory layout is sequential for
@@ -97,6 +134,29 @@ void Mesh::setupMesh() {
   glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(unsigned int),
                &indices[0], GL_STATIC_DRAW);
 
+  ConfigureVertexAttributes();
+
+  // Setup identity matrix for instance attributes (locations 8-11)
+  float identityMatrix[16] = {
+      1.0f, 0.0f, 0.0f, 0.0f, // instanceModel0
+      0.0f, 1.0f, 0.0f, 0.0f, // instanceModel1
+      0.0f, 0.0f, 1.0f, 0.0f, // instanceModel2
+      0.0f, 0.0f, 0.0f, 1.0f  // instanceModel3
+  };
+
+  glBindBuffer(GL_ARRAY_BUFFER, instanceVBO);
+  glBufferData(GL_ARRAY_BUFFER, sizeof(identityMatrix), identityMatrix,
+               GL_STATIC_DRAW);
+
+  // Instance matrix attributes default to the identity matrix in case of
+  // regular rendering
+  ConfigureInstanceAttributes();
+
+  GLState::BindVertexArray(0);
+}
+
+// Reads Vertex from the buffer bound to GL_ARRAY_BUFFER.
+void Mesh::ConfigureVertexAttributes() {
   // set the vertex attribute pointers
   // vertex Positions
   glEnableVertexAttribArray(0);
@@ -130,21 +190,11 @@ void Mesh::setupMesh() {
   glEnableVertexAttribArray(7);
   glVertexAttribPointer(7, 4, GL_FLOAT, GL_FALSE, sizeof(Vertex),
                         (void *)offsetof(Vertex, m_Weights));
+}
 
-  // Setup identity matrix for instance attributes (locations 8-11)
-  float identityMatrix[16] = {
-      1.0f, 0.0f, 0.0f, 0.0f, // instanceModel0
-      0.0f, 1.0f, 0.0f, 0.0f, // instanceModel1
-      0.0f, 0.0f, 1.0f, 0.0f, // instanceModel2
-      0.0f, 0.0f, 0.0f, 1.0f  // instanceModel3
-  };
-
-  glBindBuffer(GL_ARRAY_BUFFER, instanceVBO);
-  glBufferData(GL_ARRAY_BUFFER, sizeof(identityMatrix), identityMatrix,
-               GL_STATIC_DRAW);
-
-  // Instance matrix attributes (locations 8-11)
-  // default to identity matrix in case of regular rendering
+// Reads one mat4 per instance (locations 8-11) from the buffer bound to
+// GL_ARRAY_BUFFER.
+void Mesh::ConfigureInstanceAttributes() {
   std::size_t vec4Size = sizeof(glm::vec4);
   for (int i = 0; i < 4; ++i) {
     glEnableVertexAttribArray(8 + i);
@@ -152,50 +202,85 @@ void Mesh::setupMesh() {
                           (void *)(i * vec4Size));
     glVertexAttribDivisor(8 + i, 1);
   }
-
-  glBindVertexArray(0);
 }
 
-void Mesh::bindTextures(Shader &shader) {
-  unsigned int diffN = 1;
-  unsigned int specN = 1;
-  unsigned int normN = 1;
-  unsigned int emissionN = 1;
-  unsigned int heightN = 1;
+// Instanced draws carry their whole transform in the instance attributes.
+bool Mesh::BindMaterial() {
+  if (m_shader == nullptr)
+    return false;
+  Shader &shader = activeShader();
+  shader.use();
+  cacheUniformLocations(shader);
+  shader.setMat4(modelLocation, glm::mat4(1.0f));
+  bindTextures(shader);
+  return true;
+}
 
+void Mesh::cacheUniformLocations(const Shader &shader) {
+  if (uniformShader == &shader)
+    return;
+  uniformShader = &shader;
+  modelLocation = shader.GetUniformLocation("uModel");
+
+  // Samplers are numbered per type in texture order: diffuse1, diffuse2, ...
+  // Every mesh gives a sampler the same unit, picked from its name, so a
+  // program's samplers can be set once here, with the program bound,
+  // rather than on every draw
+  static const char *const kTypeNames[] = {"diffuse", "specular", "normal",
+                                           "emission", "height"};
+  constexpr int kTypeCount = 5;
+  int counts[kTypeCount] = {};
+
+  samplerUnits.clear();
   for (unsigned int i = 0; i < textures.size(); i++) {
-    Texture::activate(GL_TEXTURE0 + i);
-
-    string number = "0";
-    string type = "diffuse";
-    TexType name = textures[i]->type;
-    if (name == TexType::diffuse) {
-      type = "diffuse";
-      number = std::to_string(diffN++);
-    } else if (name == TexType::specular) {
-      type = "specular";
-      number = std::to_string(specN++);
-    } else if (name == TexType::normal) {
-      type = "normal";
-      number = std::to_string(normN++);
-    } else if (name == TexType::emission) {
-      type = "emission";
-      number = std::to_string(emissionN++);
-    } else if (name == TexType::height) {
-      type = "height";
-      number = std::to_string(heightN++);
+    int type = -1;
+    switch (textures[i]->type) {
+    case TexType::diffuse:
+      type = 0;
+      break;
+    case TexType::specular:
+      type = 1;
+      break;
+    case TexType::normal:
+      type = 2;
+      break;
+    case TexType::emission:
+      type = 3;
+      break;
+    case TexType::height:
+      type = 4;
+      break;
+    default:
+      break;
     }
+    int unit = -1;
+    if (type >= 0) {
+      int number = ++counts[type];
+      int location = shader.GetUniformLocation(kTypeNames[type] +
+                                               std::to_string(number));
+      if (location >= 0) {
+        unit = type + kTypeCount * (number - 1);
+        shader.setInt(location, unit);
+      }
+    }
+    samplerUnits.push_back(unit);
+  }
+}
 
-    std::string res = type + number;
-    m_shader->setInt(res.c_str(), i);
-
+// Textures the shader has no sampler for are not bound.
+void Mesh::bindTextures(Shader &shader) {
+  cacheUniformLocations(shader);
+  for (unsigned int i = 0; i < textures.size(); i++) {
+    if (samplerUnits[i] < 0)
+      continue;
+    Texture::activate(GL_TEXTURE0 + samplerUnits[i]);
     textures[i]->bind();
   }
 }
 
 void Mesh::unbindTextures() {
   Texture::activate(GL_TEXTURE0);
-  glBindTexture(GL_TEXTURE_2D, 0);
+  GLState::BindTexture2D(0);
 }
 
 void Mesh::InitializeInstanceBuffer() {
@@ -203,20 +288,13 @@ void Mesh::InitializeInstanceBuffer() {
     return;
 
   glGenBuffers(1, &instanceVBO);
-  glBindVertexArray(arrayObj);
+  GLState::BindVertexArray(arrayObj);
   glBindBuffer(GL_ARRAY_BUFFER, instanceVBO);
 
-  // Set attribute layout for mat4 (locations 8 to 11)
-  std::size_t vec4Size = sizeof(glm::vec4);
-  for (int i = 0; i < 4; ++i) {
-    glEnableVertexAttribArray(8 + i);
-    glVertexAttribPointer(8 + i, 4, GL_FLOAT, GL_FALSE, sizeof(glm::mat4),
-                          (void *)(i * vec4Size));
-    glVertexAttribDivisor(8 + i, 1);
-  }
+  ConfigureInstanceAttributes();
 
   glBindBuffer(GL_ARRAY_BUFFER, 0);
-  glBindVertexArray(0);
+  GLState::BindVertexArray(0);
 
   instancingInitialized = true;
 }
@@ -224,34 +302,12 @@ void Mesh::InitializeInstanceBuffer() {
 void Mesh::UpdateInstanceData(const std::vector<glm::mat4> &instanceMatrices) {
   if (!instancingInitialized)
     InitializeInstanceBuffer();
+  // A draw still waiting in the queue reads the old contents
+  if (queued && DrawQueue::Active() != nullptr)
+    DrawQueue::Active()->Flush();
 
   glBindBuffer(GL_ARRAY_BUFFER, instanceVBO);
   glBufferData(GL_ARRAY_BUFFER, instanceMatrices.size() * sizeof(glm::mat4),
                instanceMatrices.data(), GL_DYNAMIC_DRAW);
   glBindBuffer(GL_ARRAY_BUFFER, 0);
 }
-
-void Mesh::applyShadingUniforms() {
-  switch (m_currentShadingParams.mode) {
-  case ViewportShadingMode::Wireframe:
-    m_shader->setFloat("wireframeWidth", m_currentShadingParams.wireframeWidth);
-    m_shader->setVec3("wireframeColor", m_currentShadingParams.wireframeColor);
-    m_shader->setBool("useFill", m_currentShadingParams.useFilledWireframe);
-    m_shader->setVec3("fillColor", m_currentShadingParams.filledWireframeColor);
-    break;
-  case ViewportShadingMode::SolidColor:
-    m_shader->setVec3("color", m_currentShadingParams.solidColor);
-    break;
-  case ViewportShadingMode::RenderedNoLights:
-    m_shader->setBool("useLights", false);
-    break;
-  case ViewportShadingMode::RenderedWithLights:
-    m_shader->setBool("useLights", true);
-    m_shader->setVec3("light.direction", m_currentShadingParams.lightDirection);
-    m_shader->setVec3("light.ambient", m_currentShadingParams.lightColor *
-                                           m_currentShadingParams.ambient);
-    m_shader->setVec3("light.diffuse", m_currentShadingParams.lightColor *
-                                           m_currentShadingParams.diffuse);
-    break;
-  }
-}
\ No newline at end of file
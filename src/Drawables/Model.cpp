@@ -1,5 +1,8 @@
 #include <GenWorld/Drawables/Model.h>
+#include <GenWorld/Utils/MeshSimplifier.h>
+#include <GenWorld/Utils/Profiler.h>
 #include <GenWorld/Utils/Utils.h>
+#include <future>
 
 void Model::Draw(Shader &shader) {
   for (unsigned int i = 0; i < meshes.size(); i++) {
@@ -16,8 +19,9 @@ void Model::Draw(const glm::mat4 &view, const glm::mat4 &projection) {
 }
 
 void Model::DrawInstanced(const glm::mat4 &view, const glm::mat4 &projection,
-                          const std::vector<glm::mat4> &instanceMatrices) {
-  for (Mesh *mesh : meshes) {
+                          const std::vector<glm::mat4> &instanceMatrices,
+                          int lod) {
+  for (Mesh *mesh : GetLodMeshes(lod)) {
     mesh->UpdateInstanceData(instanceMatrices); // buffer updated here
     mesh->DrawInstanced(instanceMatrices.size(), view, projection);
   }
@@ -28,6 +32,8 @@ void Model::SetShader(std::shared_ptr<Shader> shader) {
   for (auto &mesh : meshes) {
     mesh->SetShader(shader);
   }
+  for (auto &mesh : lodStorage)
+    mesh->SetShader(shader);
 }
 
 void Model::SetShader(const std::string &shaderName) {
@@ -39,6 +45,8 @@ void Model::SetShader(const std::string &shaderName) {
   for (auto &mesh : meshes) {
     mesh->SetShader(m_shader);
   }
+  for (auto &mesh : lodStorage)
+    mesh->SetShader(m_shader);
 }
 
 void Model::SetShaderParameters(const ShadingParameters &params) {
@@ -46,6 +54,8 @@ void Model::SetShaderParameters(const ShadingParameters &params) {
   for (auto &mesh : meshes) {
     mesh->SetShaderParameters(params);
   }
+  for (auto &mesh : lodStorage)
+    mesh->SetShaderParameters(params);
 }
 
 void Model::loadModel(string path) {
@@ -65,6 +75,77 @@ void Model::loadModel(string path) {
   }
 
   processNode(scene->mRootNode, scene);
+
+  // Culling tests instances against these, so they are found once here
+  for (const Mesh *mesh : meshes)
+    for (const Vertex &vertex : mesh->vertices)
+      bounds.Add(vertex.Position);
+  buildLods();
+}
+
+const std::vector<Mesh *> &Model::GetLodMeshes(int level) const {
+  if (level <= 0 || lods.empty())
+    return meshes;
+  return lods[std::min<size_t>(level, lods.size()) - 1];
+}
+
+void Model::buildLods() {
+  Utils::Profiler::Scope scope("Build LODs");
+  // Each level aims for half the triangles of the one before, within an
+  // error bound, as a fraction of the model's size, that grows per level
+  static constexpr float kLodError[kMaxLods - 1] = {0.01f, 0.025f, 0.06f};
+  // A level that keeps more than this share of the previous one's
+  // triangles is not worth a draw list of its own; no level follows it
+  static constexpr float kMinReduction = 0.8f;
+
+  if (meshes.empty() || bounds.IsEmpty())
+    return;
+  float size = glm::length(bounds.max - bounds.min);
+
+  std::vector<std::vector<unsigned int>> current;
+  size_t currentCount = 0;
+  for (const Mesh *mesh : meshes) {
+    current.push_back(mesh->indices);
+    currentCount += mesh->indices.size();
+  }
+
+  for (int level = 1; level < kMaxLods; ++level) {
+    // Meshes simplify independently; only the uploads need this thread
+    std::vector<std::future<std::vector<unsigned int>>> tasks;
+    for (size_t i = 0; i < meshes.size(); ++i)
+      tasks.push_back(std::async(std::launch::async, [&, i] {
+        return MeshSimplifier::Simplify(meshes[i]->vertices, current[i],
+                                        current[i].size() / 2,
+                                        kLodError[level - 1] * size);
+      }));
+    std::vector<std::vector<unsigned int>> next;
+    size_t nextCount = 0;
+    for (auto &task : tasks) {
+      next.push_back(task.get());
+      nextCount += next.back().size();
+    }
+    if (nextCount > currentCount * kMinReduction)
+      break;
+
+    // A mesh that could not shrink keeps drawing its previous level
+    const std::vector<Mesh *> &previous = GetLodMeshes(level - 1);
+    std::vector<Mesh *> levelMeshes;
+    for (size_t i = 0; i < meshes.size(); ++i) {
+      if (next[i].size() == current[i].size()) {
+        levelMeshes.push_back(previous[i]);
+        continue;
+      }
+      std::vector<unsigned int> indices = next[i];
+      std::vector<Vertex> vertices =
+          MeshSimplifier::Compact(meshes[i]->vertices, indices);
+      lodStorage.push_back(
+          std::make_unique<Mesh>(vertices, indices, meshes[i]->textures));
+      levelMeshes.push_back(lodStorage.back().get());
+    }
+    lods.push_back(std::move(levelMeshes));
+    current = std::move(next);
+    currentCount = nextCount;
+  }
 }
 
 void Model::processNode(aiNode *node, const aiScene *scene) {
@@ -1,5 +1,16 @@
+#include <GenWorld/Core/GLState.h>
 #include <GenWorld/Core/stb_image_write.h>
 #include <GenWorld/Drawables/TerrainMesh.h>
+#include <GenWorld/Drawables/Impostor.h>
+#include <GenWorld/Drawables/IndirectBatch.h>
+#include <GenWorld/Drawables/InstanceCuller.h>
+#include <algorithm>
+
+namespace {
+// Array sizes the terrain shader is limited to
+constexpr size_t kMaxTextureLayers = 16;
+constexpr size_t kMaxColorLayers = 32;
+} // namespace
 
 TerrainMesh::TerrainMesh(vector<Vertex> vertices, vector<unsigned int> indices,
                          TerrainUtilities::TerrainData terrainData,
@@ -14,7 +25,7 @@ TerrainMesh::TerrainMesh(vector<Vertex> vertices, vector<unsigned int> indices,
 
   // Create a texture for the height map
   glGenTextures(1, &heightmapTextureID);
-  glBindTexture(GL_TEXTURE_2D, heightmapTextureID);
+  GLState::BindTexture2D(heightmapTextureID);
   glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
   glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
   glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
@@ -23,14 +34,14 @@ TerrainMesh::TerrainMesh(vector<Vertex> vertices, vector<unsigned int> indices,
                terrainData.numCellsLength, 0, GL_RED, GL_FLOAT,
                heightMap.data());
   glGenerateMipmap(GL_TEXTURE_2D);
-  glBindTexture(GL_TEXTURE_2D, 0);
+  GLState::BindTexture2D(0);
 
   RenderToTexture();
 }
 
 TerrainMesh::~TerrainMesh() {
-  glDeleteTextures(1, &heightmapTextureID);
-  glDeleteTextures(1, &resultTextureID);
+  GLState::DeleteTexture(heightmapTextureID);
+  GLState::DeleteTexture(resultTextureID);
 }
 
 void TerrainMesh::Draw(Shader &shader) {
@@ -65,6 +76,8 @@ void TerrainMesh::AddInstance(const std::string &modelPath,
   }
 
   modelInstances[modelPath].push_back(transform.getModelMatrix());
+  instanceCuller.reset();
+  instanceBatch.reset();
 }
 
 void TerrainMesh::RenderToTexture() {
@@ -83,10 +96,9 @@ void TerrainMesh::RenderToTexture() {
   bindTextures(*textureShader);
   GLuint emptyVAO;
   glGenVertexArrays(1, &emptyVAO);
-  glBindVertexArray(emptyVAO);
+  GLState::BindVertexArray(emptyVAO);
   glDrawArrays(GL_TRIANGLES, 0, 6);
-  glBindVertexArray(0);
-  glDeleteVertexArrays(1, &emptyVAO);
+  GLState::DeleteVertexArray(emptyVAO);
   unbindTextures();
 
   // Read the pixels from the framebuffer
@@ -96,7 +108,7 @@ void TerrainMesh::RenderToTexture() {
 
   // Create a texture for the result
   glGenTextures(1, &resultTextureID);
-  glBindTexture(GL_TEXTURE_2D, resultTextureID);
+  GLState::BindTexture2D(resultTextureID);
   glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
   glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
   glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
@@ -104,58 +116,153 @@ void TerrainMesh::RenderToTexture() {
   glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, 1024, 1024, 0, GL_RGBA,
                GL_UNSIGNED_BYTE, pixels);
   glGenerateMipmap(GL_TEXTURE_2D);
-  glBindTexture(GL_TEXTURE_2D, 0);
+  GLState::BindTexture2D(0);
 
   delete[] pixels;
   frameBuffer.Destroy();
 }
 
+const TerrainMesh::TerrainUniforms &
+TerrainMesh::uniformsFor(const Shader &shader) {
+  // Both the terrain and the texture-bake shader bind through here, so the
+  // handles are kept per shader; the element names are only built once
+  auto it = uniformCache.find(&shader);
+  if (it != uniformCache.end())
+    return it->second;
+
+  TerrainUniforms uniforms;
+  uniforms.textureCount = shader.GetUniformLocation("textureCount");
+  uniforms.coloringMode = shader.GetUniformLocation("coloringMode");
+  uniforms.colorCount = shader.GetUniformLocation("colorCount");
+  uniforms.heightmap = shader.GetUniformLocation("heightmap");
+  for (size_t i = 0; i < data.loadedTextures.size(); i++) {
+    std::string name = "loadedTextures[" + std::to_string(i) + "]";
+    uniforms.textures.push_back({shader.GetUniformLocation(name + ".texture"),
+                                 shader.GetUniformLocation(name + ".height"),
+                                 shader.GetUniformLocation(name + ".tiling"),
+                                 shader.GetUniformLocation(name + ".offset")});
+  }
+  for (size_t i = 0; i < data.colors.size(); i++) {
+    std::string name = "colors[" + std::to_string(i) + "]";
+    uniforms.colors.push_back({shader.GetUniformLocation(name + ".height"),
+                               shader.GetUniformLocation(name + ".color")});
+  }
+  return uniformCache.emplace(&shader, std::move(uniforms)).first->second;
+}
+
+// The terrain shader is also specialised to the colouring mode and the
+// number of layers it blends, which only change when the terrain is rebuilt.
+void TerrainMesh::shaderDefines(std::vector<std::string> &defines) const {
+  Mesh::shaderDefines(defines);
+  ViewportShadingMode mode = m_currentShadingParams.mode;
+  if (mode != ViewportShadingMode::RenderedWithLights &&
+      mode != ViewportShadingMode::RenderedNoLights)
+    return;
+  if (data.coloringMode) {
+    defines.push_back("TEXTURED");
+    defines.push_back("TEXTURE_COUNT " +
+                      std::to_string(std::min<size_t>(
+                          data.loadedTextures.size(), kMaxTextureLayers)));
+  } else {
+    defines.push_back("COLOR_COUNT " +
+                      std::to_string(std::min<size_t>(data.colors.size(),
+                                                      kMaxColorLayers)));
+  }
+}
+
 void TerrainMesh::bindTextures(Shader &shader) {
-  std::vector<TerrainUtilities::TextureData> loadedTextures =
-      data.loadedTextures;
+  const auto &loadedTextures = data.loadedTextures;
+  const TerrainUniforms &uniforms = uniformsFor(shader);
 
-  shader.setInt("textureCount", loadedTextures.size());
-  shader.setBool("coloringMode", data.coloringMode);
+  // Only the texture-bake shader still reads the counts and the mode; the
+  // terrain shader has them compiled in
+  shader.setInt(uniforms.textureCount, loadedTextures.size());
+  shader.setBool(uniforms.coloringMode, data.coloringMode);
 
   for (int i = 0; i < loadedTextures.size(); i++) {
     Texture::activate(GL_TEXTURE0 + i);
 
-    std::string name = "loadedTextures[" + std::to_string(i) + "]";
-    shader.setInt(name + ".texture", i);
-    shader.setFloat(name + ".height", loadedTextures[i].height);
-    shader.setVec2(name + ".tiling", loadedTextures[i].tiling);
-    shader.setVec2(name + ".offset", loadedTextures[i].offset);
+    const auto &locations = uniforms.textures[i];
+    shader.setInt(locations.texture, i);
+    shader.setFloat(locations.height, loadedTextures[i].height);
+    shader.setVec2(locations.tiling, loadedTextures[i].tiling);
+    shader.setVec2(locations.offset, loadedTextures[i].offset);
 
     loadedTextures[i].texture->bind();
   }
 
-  shader.setInt("colorCount", data.colors.size());
+  shader.setInt(uniforms.colorCount, data.colors.size());
   for (int i = 0; i < data.colors.size(); i++) {
-    std::string name = "colors[" + std::to_string(i) + "]";
-    shader.setFloat(name + ".height", data.colors[i].height);
-    shader.setVec4(name + ".color", data.colors[i].color);
+    shader.setFloat(uniforms.colors[i].height, data.colors[i].height);
+    shader.setVec4(uniforms.colors[i].color, data.colors[i].color);
   }
 
   // Bind the height map texture
   Texture::activate(GL_TEXTURE0 + loadedTextures.size());
-  shader.setInt("heightmap", loadedTextures.size());
-  glBindTexture(GL_TEXTURE_2D, heightmapTextureID);
+  shader.setInt(uniforms.heightmap, loadedTextures.size());
+  GLState::BindTexture2D(heightmapTextureID);
 }
 
 void TerrainMesh::DrawInstances(const glm::mat4 &view,
                                 const glm::mat4 &projection) {
-  for (const auto &pair : modelInstances) {
-    const std::string &modelPath = pair.first;
-    const std::vector<glm::mat4> &instances = pair.second;
+  // The scatter is indexed once, after the last AddInstance, and culled
+  // against the view every frame
+  if (!instanceCuller) {
+    std::vector<IndirectBatch::Source> sources;
+    sourceImpostors.clear();
+    for (const auto &pair : modelInstances) {
+      auto modelIt = instanceMeshes.find(pair.first);
+      if (pair.second.empty() || modelIt == instanceMeshes.end() ||
+          !modelIt->second)
+        continue;
+      sources.emplace_back(modelIt->second.get(), &pair.second);
+      // Impostors outlive the scatter; the atlas only depends on the model
+      auto &impostor = impostors[pair.first];
+      if (!impostor)
+        impostor = std::make_unique<Impostor>(*modelIt->second, pair.first);
+      sourceImpostors.push_back(impostor.get());
+    }
+    instanceCuller = std::make_unique<InstanceCuller>(sources);
+    for (size_t s = 0; s < sourceImpostors.size(); ++s)
+      if (sourceImpostors[s]->IsReady())
+        instanceCuller->EnableImpostor(s);
+    // With GL 4.3 the models are packed and drawn with one multi-draw per
+    // material
+    if (IndirectBatch::IsSupported())
+      instanceBatch = std::make_unique<IndirectBatch>(sources);
+  }
+  // The atlas holds the models' colours, so wireframe and solid views draw
+  // the far scatter as models too
+  ViewportShadingMode mode = m_currentShadingParams.mode;
+  bool rendered = mode == ViewportShadingMode::RenderedWithLights ||
+                  mode == ViewportShadingMode::RenderedNoLights;
+  instanceCuller->SetImpostorsActive(rendered);
+  instanceCuller->Cull(view, projection);
+  const auto &visible = instanceCuller->Visible();
+  if (rendered)
+    for (size_t s = 0; s < sourceImpostors.size(); ++s)
+      sourceImpostors[s]->Draw(
+          instanceCuller->Impostors(s), InstanceCuller::kImpostorCoverage,
+          InstanceCuller::kImpostorCoverage * InstanceCuller::kImpostorFade,
+          mode == ViewportShadingMode::RenderedWithLights);
+
+  if (instanceBatch) {
+    for (auto &pair : instanceMeshes)
+      if (pair.second)
+        pair.second->SetShaderParameters(m_currentShadingParams);
+    instanceBatch->SetInstances(visible);
+    instanceBatch->Draw();
+    return;
+  }
 
-    if (instances.empty())
+  for (size_t list = 0; list < visible.size(); ++list) {
+    if (visible[list]->empty())
       continue;
-
-    std::shared_ptr<Model> model = instanceMeshes[modelPath];
-    if (model) {
-      model->SetShaderParameters(m_currentShadingParams);
-      model->DrawInstanced(view, projection, instances);
-    }
+    size_t source = instanceCuller->ListSource(list);
+    Model *model = instanceCuller->Sources()[source].first;
+    model->SetShaderParameters(m_currentShadingParams);
+    model->DrawInstanced(view, projection, *visible[list],
+                         instanceCuller->ListLevel(list));
   }
 }
 
@@ -0,0 +1,14 @@
+#include <GenWorld/Generators/AssetRegistry.h>
+#include <utility>
+
+void AssetRegistry::Add(int id, const std::string &name,
+                        const std::string &path,
+                        const std::shared_ptr<Model> &model) {
+  if (id < 0 || Contains(id))
+    return;
+
+  if (id >= static_cast<int>(slots.size()))
+    slots.resize(id + 1, -1);
+  slots[id] = static_cast<int>(entries.size());
+  entries.push_back({id, name, path, model});
+}
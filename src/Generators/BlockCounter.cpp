@@ -0,0 +1,102 @@
+#include <GenWorld/Generators/BlockCounter.h>
+#include <GenWorld/Generators/WFC/VariantMask.h>
+#include <algorithm>
+#include <climits>
+
+void BlockCounter::Reset(int idLimit) {
+  size_t size = static_cast<size_t>(idLimit < 0 ? 0 : idLimit);
+  counts.assign(size, 0);
+  minCounts.assign(size, 0);
+  maxCounts.assign(size, -1);
+  exempt.assign(size, 0);
+  saturated.assign(size, 0);
+  shortOf.assign(size, 0);
+  shortBlocks = 0;
+  deficits.clear();
+  deficits.reserve(size);
+  deficitSlot.assign(size, -1);
+  blockVariants.assign(size, {});
+  std::fill(saturatedMask.begin(), saturatedMask.end(), 0);
+}
+
+void BlockCounter::SetLimits(int blockId, int minCount, int maxCount,
+                             bool isExempt) {
+  if (!known(blockId))
+    return;
+  minCounts[blockId] = minCount;
+  maxCounts[blockId] = maxCount;
+  exempt[blockId] = isExempt;
+  update(blockId);
+}
+
+void BlockCounter::SetVariants(const std::vector<int> &variantBlocks,
+                               int words) {
+  saturatedMask.assign(words, 0);
+  for (auto &variants : blockVariants)
+    variants.clear();
+  for (int v = 0; v < static_cast<int>(variantBlocks.size()); ++v) {
+    int blockId = variantBlocks[v];
+    if (!known(blockId))
+      continue;
+    blockVariants[blockId].push_back(v);
+    if (saturated[blockId])
+      WFC::SetBit(saturatedMask.data(), v);
+  }
+}
+
+int BlockCounter::Add(int blockId, int delta) {
+  if (!known(blockId))
+    return kNone;
+  counts[blockId] += delta;
+  return update(blockId);
+}
+
+int BlockCounter::Remaining(int blockId) const {
+  if (!known(blockId) || maxCounts[blockId] < 0)
+    return INT_MAX;
+  return maxCounts[blockId] - counts[blockId];
+}
+
+int BlockCounter::Shortfall(int blockId) const {
+  if (!known(blockId) || !isShort(blockId))
+    return 0;
+  return minCounts[blockId] - counts[blockId];
+}
+
+int BlockCounter::update(int blockId) {
+  int change = kNone;
+
+  bool full = isSaturated(blockId);
+  if (full != static_cast<bool>(saturated[blockId])) {
+    saturated[blockId] = full;
+    for (int v : blockVariants[blockId])
+      if (full)
+        WFC::SetBit(saturatedMask.data(), v);
+      else
+        WFC::ClearBit(saturatedMask.data(), v);
+    change |= kSaturation;
+  }
+
+  bool below = isShort(blockId);
+  if (below != static_cast<bool>(shortOf[blockId])) {
+    shortOf[blockId] = below;
+    shortBlocks += below ? 1 : -1;
+  }
+
+  // The deficit set swaps the last entry into a removed one's place
+  bool needed = below && !full;
+  int &slot = deficitSlot[blockId];
+  if (needed && slot < 0) {
+    slot = static_cast<int>(deficits.size());
+    deficits.push_back(blockId);
+    change |= kDeficit;
+  } else if (!needed && slot >= 0) {
+    int last = deficits.back();
+    deficits[slot] = last;
+    deficitSlot[last] = slot;
+    deficits.pop_back();
+    slot = -1;
+    change |= kDeficit;
+  }
+  return change;
+}
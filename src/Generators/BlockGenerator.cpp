@@ -2,24 +2,29 @@
 #include <GenWorld/Core/Vertex.h>
 #include <GenWorld/Drawables/BlockMesh.h>
 #include <GenWorld/Drawables/Model.h>
+#include <GenWorld/Generators/AssetRegistry.h>
+#include <GenWorld/Generators/BlockCounter.h>
 #include <GenWorld/Generators/BlockGenerator.h>
+#include <GenWorld/Generators/WFC/ChunkedSolver.h>
+#include <GenWorld/Generators/WFC/VariantMask.h>
 #include <GenWorld/UI/BlockUI.h>
+#include <GenWorld/Utils/Profiler.h>
 #include <algorithm>
 #include <atomic>
 #include <cfloat>
 #include <chrono>
+#include <climits>
+#include <condition_variable>
 #include <future>
+#include <glm/gtc/matrix_transform.hpp>
 #include <iostream>
 #include <map>
+#include <memory>
 #include <mutex>
-#include <queue>
 #include <random>
-#include <set>
 #include <thread>
 #include <tuple>
 
-std::mutex gridMutex;
-
 BlockGenerator::BlockGenerator(BlockController *controller)
     : controller(controller) {
   initializeDefaults();
@@ -30,28 +35,51 @@ BlockGenerator::~BlockGenerator() { delete generatorMesh; }
 void BlockGenerator::initializeDefaults() {
   parameters = {20, 10, 20, 5.0f, 5.0f, 5.0f, 1.0f};
   generatorMesh = nullptr;
-
-  // Initialize grid mask if needed
-  if (parameters.generationSettings.isGridMaskEnabled) {
-    initializeGridMask();
-  }
+  // The grid mask is applied by initializeGrid() once the wave exists
 }
 
 void BlockGenerator::Generate() {
-  std::mt19937 mainRng(parameters.randomSeed);
-  if (!(controller && controller->GetBlockUI() &&
-        !controller->GetBlockUI()->GetLoadedAssets().empty())) {
+  snapshotAssets();
+  if (assets->Empty()) {
     std::cerr << "ERROR: No blocks/models loaded. Generation aborted."
               << std::endl;
     generatorMesh = createEmptyMesh();
     return;
   }
+  // Once, before any solver is forked, so they all share the cell size
+  if (!parameters.dimensionsDetected)
+    DetectCellSizeFromAssets();
+
+  if (parameters.generationSettings.portfolioSize > 1) {
+    generatePortfolio();
+    return;
+  }
+  solve();
+
+  // Print generation statistics
+  printGenerationSummary();
+
+  generatorMesh = generateMeshFromGrid();
+}
+
+void BlockGenerator::snapshotAssets() {
+  // The only place the controller is read; solves work on this copy, so
+  // several generators can run side by side
+  auto registry = std::make_shared<AssetRegistry>();
+  if (controller && controller->GetBlockUI())
+    for (const auto &asset : controller->GetBlockUI()->GetLoadedAssets())
+      registry->Add(asset.id, asset.name, asset.blockPath, asset.model);
+  assets = std::move(registry);
+}
+
+bool BlockGenerator::solve() {
+  Utils::Profiler::Scope scope("Solve");
+  std::mt19937 mainRng(parameters.randomSeed);
   isFirstBlock = true;
+  interrupted = false;
   initializeSocketSystem();
   initializeBlockWeights();
   resetBlockCounts();
-  if (!parameters.dimensionsDetected)
-    DetectCellSizeFromAssets();
   initializeGrid();
 
   // Check if rectangular castle generation is enabled
@@ -60,128 +88,247 @@ void BlockGenerator::Generate() {
   } else {
     generateGridFrontierWFC(mainRng);
   }
+  publishBlockCounts();
+  return !interrupted;
+}
 
-  // Check if minimum requirements are met
-  if (!hasMetMinimumRequirements()) {
-    auto blocksNeeded = getBlocksNeedingMinCount();
+bool BlockGenerator::shouldStop() {
+  // Recorded only where a loop stops for it; a cancel that arrives after
+  // the loops ended does not make the solve incomplete
+  if (cancelFlag && *cancelFlag)
+    interrupted = true;
+  return interrupted;
+}
 
-    for (int blockId : blocksNeeded) {
-      auto &settings = parameters.generationSettings;
-      auto currentIt = settings.currentBlockCounts.find(blockId);
-      auto minIt = settings.minBlockCounts.find(blockId);
-      int current = (currentIt != settings.currentBlockCounts.end())
-                        ? currentIt->second
-                        : 0;
-      int needed = (minIt != settings.minBlockCounts.end()) ? minIt->second : 0;
+void BlockGenerator::generatePortfolio() {
+  auto &settings = parameters.generationSettings;
+  int count = settings.portfolioSize;
+
+  // Solve 0 keeps the configured seed; the others draw theirs from it
+  std::mt19937 seeder(parameters.randomSeed);
+  std::atomic<bool> cancel{false};
+  std::mutex resultMutex;
+  std::condition_variable resultReady;
+  std::vector<int> scores(count, -1); // -1 until the solve has run
+  std::vector<bool> complete(count, false);
+  int finished = 0, perfect = -1;
+
+  std::vector<std::unique_ptr<BlockGenerator>> solvers;
+  for (int i = 0; i < count; ++i) {
+    auto solver = std::make_unique<BlockGenerator>();
+    solver->parameters = parameters;
+    solver->parameters.randomSeed = i == 0 ? parameters.randomSeed : seeder();
+    solver->assets = assets;
+    solver->cancelFlag = &cancel;
+    solvers.push_back(std::move(solver));
+  }
+
+  // One worker per core takes the solves in order. Solves not started by
+  // the time the result is in are skipped, except solve 0, so there is
+  // always one to pick.
+  std::atomic<int> next{0};
+  auto worker = [&] {
+    int i;
+    while ((i = next++) < count && !(i > 0 && cancel)) {
+      bool done = solvers[i]->solve();
+      int score = solvers[i]->scoreSolution();
+      std::lock_guard<std::mutex> lock(resultMutex);
+      scores[i] = score;
+      complete[i] = done;
+      finished++;
+      if (score == 0 && done && perfect < 0)
+        perfect = i;
+      resultReady.notify_one();
     }
-    std::cout << std::endl;
-  }
+  };
+  int threads =
+      std::max(1, static_cast<int>(std::thread::hardware_concurrency()));
+  std::vector<std::future<void>> workers;
+  for (int t = 0; t < std::min(threads, count); ++t)
+    workers.push_back(std::async(std::launch::async, worker));
+
+  // Wait for a solve that meets every constraint, for all of them to end,
+  // or for the deadline; whatever is still running is then cancelled
+  {
+    std::unique_lock<std::mutex> lock(resultMutex);
+    auto done = [&] { return perfect >= 0 || finished == count; };
+    if (settings.portfolioDeadlineMs > 0)
+      resultReady.wait_for(
+          lock, std::chrono::milliseconds(settings.portfolioDeadlineMs),
+          done);
+    else
+      resultReady.wait(lock, done);
+  }
+  cancel = true;
+  for (auto &task : workers)
+    task.get();
+
+  // Lowest score wins; a solve cut off by the deadline only counts when
+  // none ran to completion
+  int winner = perfect;
+  if (winner < 0) {
+    bool anyComplete =
+        std::find(complete.begin(), complete.end(), true) != complete.end();
+    for (int i = 0; i < count; ++i)
+      if (scores[i] >= 0 && (complete[i] || !anyComplete) &&
+          (winner < 0 || scores[i] < scores[winner]))
+        winner = i;
+  }
+
+  std::cout << "Portfolio: solve " << winner + 1 << "/" << count
+            << " won with seed " << solvers[winner]->parameters.randomSeed
+            << " (score " << scores[winner] << ")" << std::endl;
+  adoptSolution(*solvers[winner]);
 
-  // Print generation statistics
   printGenerationSummary();
-
   generatorMesh = generateMeshFromGrid();
 }
 
+void BlockGenerator::adoptSolution(BlockGenerator &solver) {
+  // The solved state moves over whole, so this generator answers queries
+  // about the grid as if it had solved it. The wave points at its owner's
+  // rules and is re-pointed once both have moved.
+  auto seed = parameters.randomSeed;
+  parameters = std::move(solver.parameters);
+  parameters.randomSeed = seed;
+  adjacencyRules = std::move(solver.adjacencyRules);
+  wave = std::move(solver.wave);
+  wave.SetRules(&adjacencyRules);
+  cellRotation = std::move(solver.cellRotation);
+  blockCounter = std::move(solver.blockCounter);
+  solidFaces = std::move(solver.solidFaces);
+}
+
+int BlockGenerator::scoreSolution() const {
+  // 0 when every constraint holds: no socket left dangling and every
+  // minimum count reached
+  int score = countDanglingSockets();
+  for (int blockId : getBlocksNeedingMinCount())
+    score += blockCounter.Shortfall(blockId);
+  return score;
+}
+
+int BlockGenerator::countDanglingSockets() const {
+  int dangling = 0;
+  for (int cell = 0; cell < wave.CellCount(); ++cell) {
+    int variant = wave.Chosen(cell);
+    if (variant < 0)
+      continue;
+    wave.ForEachNeighbor(cell, [&](int face, int neighbor) {
+      if (!wave.IsBlocked(neighbor) && !wave.IsCollapsed(neighbor) &&
+          adjacencyRules.ExpectsNeighbor(variant, face))
+        dangling++;
+    });
+  }
+  return dangling;
+}
+
 void BlockGenerator::initializeSocketSystem() {
   parameters.socketSystem.Initialize();
-  if (controller && controller->GetBlockUI()) {
-    auto assets = controller->GetBlockUI()->GetLoadedAssets();
-    auto &templates = parameters.socketSystem.GetBlockTemplates();
-    for (const auto &asset : assets) {
-      if (templates.find(asset.id) == templates.end()) {
-        BlockTemplate blockTemplate(asset.id);
-        blockTemplate.name = asset.name;
-        parameters.socketSystem.AddBlockTemplate(blockTemplate);
-      }
-      parameters.blockRotations[asset.id] = 0;
+  auto &templates = parameters.socketSystem.GetBlockTemplates();
+  for (const auto &asset : assets->Entries()) {
+    if (templates.find(asset.id) == templates.end()) {
+      BlockTemplate blockTemplate(asset.id);
+      blockTemplate.name = asset.name;
+      parameters.socketSystem.AddBlockTemplate(blockTemplate);
     }
+    parameters.blockRotations[asset.id] = 0;
   }
   parameters.socketSystem.GenerateRotatedVariants();
   buildAdjacencyTable();
 }
 
 void BlockGenerator::generateGridFrontierWFC(std::mt19937 &rng) {
-  const int maxRestarts = 10; // Maximum number of hard restarts allowed
-  int restartCount = 0;
-
-  runSingleWFCAttempt(rng);
-}
-
-double BlockGenerator::calculateCellEntropy(const GridCell &cell) const {
-  if (cell.collapsed || cell.possibleBlockRotationPairs.empty())
-    return 0.0;
-  double sum = 0.0, logSum = 0.0;
-  auto &weights = parameters.generationSettings.blockWeights;
-  auto blocksNeedingMin = getBlocksNeedingMinCount();
-
-  for (const auto &pair : cell.possibleBlockRotationPairs) {
-    int id = pair.first;
-    double w = weights.count(id) ? weights.at(id) : 1.0;
-
-    if (std::find(blocksNeedingMin.begin(), blocksNeedingMin.end(), id) !=
-        blocksNeedingMin.end()) {
-      w *= 1.3; // Smaller boost (30% instead of 100%) for better distribution
-    }
-
-    sum += w;
-    logSum += w * std::log(w);
+  // Grids wider than one chunk are solved chunk by chunk on every core
+  int chunkSize = parameters.generationSettings.chunkSize;
+  if (chunkSize > 0 && ((int)parameters.gridWidth > chunkSize ||
+                        (int)parameters.gridLength > chunkSize)) {
+    generateChunkedWFC(rng);
+    return;
   }
-  return std::log(sum) - (logSum / sum);
-}
 
-int BlockGenerator::selectWeightedBlock(const std::vector<int> &validBlocks,
-                                        std::mt19937 &rng) {
-  std::vector<int> availableBlocks;
-  for (int blockId : validBlocks)
-    if (canPlaceBlock(blockId))
-      availableBlocks.push_back(blockId);
-  if (availableBlocks.empty())
-    return -1;
-  return selectByWeight(availableBlocks, rng);
+  runSingleWFCAttempt(rng);
 }
 
-int BlockGenerator::selectByWeight(const std::vector<int> &blocks,
-                                   std::mt19937 &rng) {
-  if (blocks.empty())
-    return -1;
+void BlockGenerator::generateChunkedWFC(std::mt19937 &rng) {
   auto &settings = parameters.generationSettings;
 
-  // Filter out blocks with zero weight first
-  std::vector<int> validBlocks;
-  float totalWeight = 0.0f;
-
-  for (int blockId : blocks) {
-    auto it = settings.blockWeights.find(blockId);
-    float weight = (it != settings.blockWeights.end()) ? it->second : 1.0f;
-
-    // Only include blocks with positive weight
-    if (weight > 0.0f) {
-      validBlocks.push_back(blockId);
-      totalWeight += weight;
-    }
+  // Max counts are shared by all chunks, so every placement claims one unit
+  // of its block's remaining allowance atomically
+  int variantCount = adjacencyRules.VariantCount();
+  std::map<int, int> blockSlots;
+  std::vector<int> slotOf(variantCount);
+  for (int v = 0; v < variantCount; ++v) {
+    int blockId = adjacencyRules.GetVariant(v).blockId;
+    slotOf[v] = blockSlots.emplace(blockId, (int)blockSlots.size())
+                    .first->second;
+  }
+  std::vector<std::atomic<int>> remaining(blockSlots.size());
+  for (const auto &[blockId, slot] : blockSlots)
+    remaining[slot] = blockCounter.Remaining(blockId);
+  auto acquire = [&](int variant) {
+    auto &left = remaining[slotOf[variant]];
+    int count = left.load();
+    while (count > 0)
+      if (left.compare_exchange_weak(count, count - 1))
+        return true;
+    return false;
+  };
+  auto release = [&](int variant) { remaining[slotOf[variant]]++; };
+
+  std::vector<uint64_t> domain(adjacencyRules.WordCount(), 0);
+  for (int v = 0; v < variantCount; ++v)
+    if (canPlaceBlock(adjacencyRules.GetVariant(v).blockId))
+      WFC::SetBit(domain.data(), v);
+
+  WFC::ChunkedSolver::Options options;
+  options.chunkSize = settings.chunkSize;
+  options.backtrackDepth = settings.backtrackDepth;
+  options.maxBacktracks = settings.maxBacktracks;
+  options.seed = rng();
+  options.cancel = cancelFlag;
+
+  // The weights include the min-count boost as it stands now; chunks solve
+  // concurrently, so the boost is not updated while they run
+  WFC::ChunkedSolver solver;
+  solver.Solve(adjacencyRules, wave.Weights(), parameters.gridWidth,
+               parameters.gridHeight, parameters.gridLength, domain.data(),
+               options, acquire, release);
+
+  // Every cell is settled, so saturation needs no bans here
+  wave.SetJournaling(false);
+  const auto &result = solver.Result();
+  for (int cell = 0; cell < wave.CellCount(); ++cell) {
+    wave.Settle(cell, result[cell]);
+    if (result[cell] < 0)
+      continue;
+    blockCounter.Add(adjacencyRules.GetVariant(result[cell]).blockId, 1);
+    cellRotation[cell] = drawRotation(result[cell], rng);
   }
+  refreshVariantWeights();
 
-  // If no blocks have positive weight, fall back to uniform selection from all
-  // blocks
-  if (validBlocks.empty() || totalWeight <= 0.0f) {
-    std::uniform_int_distribution<int> dist(0, blocks.size() - 1);
-    return blocks[dist(rng)];
-  }
+  if (!solver.Complete())
+    interrupted = true;
 
-  // Weighted selection from blocks with positive weights
-  std::uniform_real_distribution<float> dist(0.0f, totalWeight);
-  float randomValue = dist(rng), currentWeight = 0.0f;
+  std::cout << "Chunked WFC: " << solver.ChunkCount() << " chunks, "
+            << solver.Conflicts() << " dangling sockets" << std::endl;
+}
 
-  for (int blockId : validBlocks) {
-    auto it = settings.blockWeights.find(blockId);
-    float weight = (it != settings.blockWeights.end()) ? it->second : 1.0f;
-    currentWeight += weight;
-    if (randomValue <= currentWeight)
-      return blockId;
+void BlockGenerator::refreshVariantWeights() {
+  auto &weights = parameters.generationSettings.blockWeights;
+  std::vector<double> variantWeights(adjacencyRules.VariantCount());
+  for (int v = 0; v < adjacencyRules.VariantCount(); ++v) {
+    const auto &variant = adjacencyRules.GetVariant(v);
+    int id = variant.blockId;
+    double w = weights.count(id) ? weights.at(id) : 1.0;
+    if (needsMinCount(id))
+      w *= 1.3; // Smaller boost (30% instead of 100%) for better distribution
+    // A variant stands in for all its equivalent rotations
+    variantWeights[v] = w * static_cast<double>(variant.rotations.size());
   }
-
-  return validBlocks.back();
+  // The wave keeps per-cell weight sums current as variants are banned;
+  // this only reruns when a block's boost turns on or off
+  wave.SetWeights(variantWeights);
 }
 
 void BlockGenerator::updateWorldDimensions() {
@@ -193,12 +340,13 @@ void BlockGenerator::updateWorldDimensions() {
 }
 
 void BlockGenerator::DetectCellSizeFromAssets() {
-  if (!controller || !controller->GetBlockUI())
+  // Reads the snapshot Generate() took, which portfolio solvers share; a
+  // generator without a controller would only replace it with an empty one
+  if (!assets)
+    snapshotAssets();
+  if (assets->Empty())
     return;
-  auto assets = controller->GetBlockUI()->GetLoadedAssets();
-  if (assets.empty())
-    return;
-  const auto &firstAsset = assets[0];
+  const auto &firstAsset = assets->Entries()[0];
   if (!firstAsset.model)
     return;
   glm::vec3 bounds = calculateModelBounds(firstAsset.model);
@@ -229,54 +377,46 @@ BlockGenerator::calculateModelBounds(const std::shared_ptr<Model> &model) {
 }
 
 void BlockGenerator::initializeGrid() {
-  grid.assign(
-      parameters.gridWidth,
-      std::vector<std::vector<GridCell>>(
-          parameters.gridHeight, std::vector<GridCell>(parameters.gridLength)));
-  auto &templates = parameters.socketSystem.GetBlockTemplates();
+  wave.Setup(&adjacencyRules, parameters.gridWidth, parameters.gridHeight,
+             parameters.gridLength);
+  cellRotation.assign(wave.CellCount(), 0);
+  resetDecisions();
 
-  for (auto &layer : grid) {
-    for (auto &row : layer) {
-      for (auto &cell : row) {
-        cell = {std::vector<std::pair<int, int>>(), false, {}, {}, {}, 0.0f};
-      }
-    }
+  bool maskEnabled = parameters.generationSettings.isGridMaskEnabled;
+  if (maskEnabled)
+    initializeGridMask();
+
+  // Two initial domains: every variant, and every variant except corner
+  // blocks, which the castle mask only allows at corner positions
+  int words = adjacencyRules.WordCount();
+  std::vector<uint64_t> fullDomain(words, 0), nonCornerDomain(words, 0);
+  for (int v = 0; v < adjacencyRules.VariantCount(); ++v) {
+    WFC::SetBit(fullDomain.data(), v);
+    int blockId = adjacencyRules.GetVariant(v).blockId;
+    if (!(maskEnabled &&
+          parameters.generationSettings.cornerBlockIds.count(blockId) > 0))
+      WFC::SetBit(nonCornerDomain.data(), v);
   }
 
-  // Initialize possibilities for each cell
   for (int x = 0; x < (int)parameters.gridWidth; ++x) {
     for (int y = 0; y < (int)parameters.gridHeight; ++y) {
       for (int z = 0; z < (int)parameters.gridLength; ++z) {
-        std::vector<std::pair<int, int>> cellPairs;
-
-        for (const auto &[blockId, blockTemplate] : templates) {
-          // Check if this is a corner block and we're using grid mask
-          bool isCornerBlock =
-              parameters.generationSettings.cornerBlockIds.count(blockId) > 0;
-          if (parameters.generationSettings.isGridMaskEnabled &&
-              isCornerBlock) {
-            // Corner blocks can only be placed at corner positions
-            if (!isCornerPosition(x, y, z)) {
-              continue; // Skip this corner block for non-corner positions
-            }
-          }
-
-          for (int rotation : blockTemplate.allowedRotations) {
-            cellPairs.emplace_back(blockId, rotation);
-          }
-        }
-
-        grid[x][y][z].possibleBlockRotationPairs = cellPairs;
+        int index = wave.Index(x, y, z);
+        if (wave.IsBlocked(index))
+          continue;
+        wave.SetDomain(index, isCornerPosition(x, y, z)
+                                  ? fullDomain.data()
+                                  : nonCornerDomain.data());
       }
     }
   }
+  refreshVariantWeights();
 }
 
 std::vector<int> BlockGenerator::getAllBlockTypes() {
   std::vector<int> blockTypes;
-  if (controller && controller->GetBlockUI()) {
-    auto assets = controller->GetBlockUI()->GetLoadedAssets();
-    for (const auto &asset : assets)
+  if (assets && !assets->Empty()) {
+    for (const auto &asset : assets->Entries())
       blockTypes.push_back(asset.id);
     return blockTypes;
   }
@@ -285,198 +425,187 @@ std::vector<int> BlockGenerator::getAllBlockTypes() {
   return blockTypes;
 }
 
-void BlockGenerator::updateCellPossibilities(int x, int y, int z) {
-  auto &cell = grid[x][y][z];
-  if (cell.collapsed)
-    return;
-  std::vector<std::pair<int, int>> validPairs;
-
-  auto &templates = parameters.socketSystem.GetBlockTemplates();
-  for (const auto &[blockId, blockTemplate] : templates) {
-    if (!canPlaceBlock(blockId))
-      continue;
-
-    // Check if this is a corner block and we're using grid mask
-    bool isCornerBlock =
-        parameters.generationSettings.cornerBlockIds.count(blockId) > 0;
-    if (parameters.generationSettings.isGridMaskEnabled && isCornerBlock) {
-      // Corner blocks can only be placed at corner positions
-      if (!isCornerPosition(x, y, z)) {
-        continue; // Skip this corner block for non-corner positions
-      }
-    }
-
-    for (int rotation : blockTemplate.allowedRotations) {
-      if (isBlockValidAtPosition(x, y, z, blockId, rotation)) {
-        validPairs.emplace_back(blockId, rotation);
-      }
-    }
-  }
-  cell.possibleBlockRotationPairs = validPairs;
-}
-
 bool BlockGenerator::isBlockValidAtPosition(int x, int y, int z, int blockId,
                                             int rotation) const {
-  const std::vector<std::tuple<int, int, int, int>> neighbors = {
-      {x + 1, y, z, 0}, {x - 1, y, z, 1}, {x, y + 1, z, 2},
-      {x, y - 1, z, 3}, {x, y, z + 1, 4}, {x, y, z - 1, 5}};
-  for (const auto &[nx, ny, nz, faceIndex] : neighbors) {
-    if (!isValidGridPosition(nx, ny, nz))
-      continue;
-    const auto &neighborCell = grid[nx][ny][nz];
-    if (!validateNeighborCompatibility(blockId, rotation, faceIndex,
-                                       neighborCell, nx, ny, nz))
-      return false;
-  }
-  return true;
+  int variant = adjacencyRules.FindVariant(blockId, rotation);
+  return variant >= 0 && wave.IsSupported(wave.Index(x, y, z), variant);
 }
 
 void BlockGenerator::buildAdjacencyTable() {
-  adjacencyTable.clear();
-  auto &templates = parameters.socketSystem.GetBlockTemplates();
-  for (const auto &[blockId, blockTemplate] : templates) {
-    for (int rotation : blockTemplate.allowedRotations) {
-      for (int face = 0; face < 6; ++face) {
-        for (const auto &[neighborId, neighborTemplate] : templates) {
-          for (int neighborRotation : neighborTemplate.allowedRotations) {
-            if (parameters.socketSystem.CanBlocksConnect(
-                    blockId, rotation, face, neighborId, neighborRotation,
-                    getOppositeFaceIndex(face), false)) {
-
-              adjacencyTable[{blockId, rotation, face}].insert(
-                  {neighborId, neighborRotation});
-            }
-          }
-        }
-      }
-    }
-  }
+  CompiledSockets sockets = parameters.socketSystem.Compile();
+
+  adjacencyRules.Clear();
+  for (int v = 0; v < sockets.VariantCount(); ++v) {
+    int variant =
+        adjacencyRules.AddVariant(sockets.blockIds[v], sockets.rotations[v]);
+    for (int rotation : sockets.rotationSets[v])
+      adjacencyRules.AddRotation(variant, rotation);
+  }
+  adjacencyRules.Finalize();
+
+  // Compatible(u, face) holds every v that may sit across `face` of u. The
+  // socket test is made from v's side, as the candidate being placed.
+  adjacencyRules.AllowByFaceType(
+      sockets.faceTypes, sockets.typeCount,
+      [&](int from, int to) { return sockets.CanConnect(from, to); });
+
+  // EMPTY sockets connect to anything, open air included. Every other
+  // socket is a solid face, which interior culling relies on.
+  solidFaces.assign(sockets.VariantCount(), 0);
+  for (int v = 0; v < sockets.VariantCount(); ++v)
+    for (int face = 0; face < WFC::kFaceCount; ++face)
+      if (sockets.FaceType(v, face) == static_cast<int>(SocketType::EMPTY))
+        adjacencyRules.SetExpectsNeighbor(v, face, false);
+      else
+        solidFaces[v] |= 1u << face;
 }
 
-bool BlockGenerator::validateNeighborCompatibility(int blockId, int rotation,
-                                                   int faceIndex,
-                                                   const GridCell &neighborCell,
-                                                   int neighborX, int neighborY,
-                                                   int neighborZ) const {
-  // Special case for corner blocks: if the neighbor is outside the grid or
-  // masked, check if this face should be a wall (no socket connection needed)
-  bool isCornerBlock =
-      parameters.generationSettings.cornerBlockIds.count(blockId) > 0;
-  bool neighborOutsideOrMasked =
-      !isValidGridPosition(neighborX, neighborY, neighborZ) ||
-      (parameters.generationSettings.isGridMaskEnabled &&
-       isGridCellMasked(neighborX, neighborY, neighborZ));
-
-  if (isCornerBlock && neighborOutsideOrMasked) {
-    // For corner blocks, outward-facing sides should be walls, so no socket
-    // connection is expected This is valid - the corner block's wall face is
-    // connecting to empty space
-    return true;
-  }
-
-  if (neighborCell.collapsed && !neighborCell.blockTypeIds.empty()) {
-    int neighborBlockId = neighborCell.blockTypeIds[0];
-    int neighborRotation = neighborCell.blockRotations.empty()
-                               ? 0
-                               : neighborCell.blockRotations[0];
-
-    auto key = std::make_tuple(blockId, rotation, faceIndex);
-    auto it = adjacencyTable.find(key);
-    if (it != adjacencyTable.end())
-      return it->second.count({neighborBlockId, neighborRotation}) > 0;
-    return false;
-  }
-  if (!neighborCell.collapsed) {
-    return true;
+bool BlockGenerator::isEnclosed(int cell) const {
+  int variant = wave.Chosen(cell);
+  for (int face = 0; face < WFC::kFaceCount; ++face) {
+    int neighbor = wave.Neighbor(cell, face);
+    int other = neighbor < 0 ? -1 : wave.Chosen(neighbor);
+    if (other < 0 || !((solidFaces[variant] >> face) & 1) ||
+        !((solidFaces[other] >> WFC::OppositeFace(face)) & 1))
+      return false;
   }
   return true;
 }
 
 BlockMesh *BlockGenerator::generateMeshFromGrid() {
-  std::vector<Vertex> vertices;
-  std::vector<unsigned int> indices;
-  std::vector<std::shared_ptr<Texture>> textures;
-  std::set<std::shared_ptr<Texture>> uniqueTextures;
-  BlockMesh *blockMesh = new BlockMesh(vertices, indices, parameters, textures);
-  unsigned int numThreads = std::thread::hardware_concurrency();
-  std::vector<std::vector<std::tuple<int, glm::vec3, int>>> threadBlocks(
-      numThreads);
-  std::vector<std::set<std::shared_ptr<Texture>>> threadTextures(numThreads);
-
-  auto meshWorker = [&](unsigned int threadId, unsigned int startX,
-                        unsigned int endX) {
-    for (unsigned int x = startX; x < endX; x++) {
+  Utils::Profiler::Scope scope("Block Mesh");
+  BlockMesh *blockMesh = createEmptyMesh();
+  int variantCount = adjacencyRules.VariantCount();
+  unsigned int numThreads = std::max(1u, std::thread::hardware_concurrency());
+  numThreads = std::min(numThreads, std::max(1u, parameters.gridWidth));
+
+  auto forEachSlab = [&](auto &&work) {
+    unsigned int slabWidth = parameters.gridWidth / numThreads,
+                 remainder = parameters.gridWidth % numThreads, startX = 0;
+    std::vector<std::thread> workers;
+    for (unsigned int t = 0; t < numThreads; ++t) {
+      unsigned int endX = startX + slabWidth + (t < remainder ? 1 : 0);
+      workers.emplace_back(work, t, startX, endX);
+      startX = endX;
+    }
+    for (auto &th : workers)
+      th.join();
+  };
+  // Blocks are bucketed by variant and by whether every face is sealed by
+  // a solid neighbour face. Sealed blocks are never drawn, and only reach
+  // the mesh at all when they are kept for export.
+  const auto &settings = parameters.generationSettings;
+  bool cullInterior = settings.cullInteriorBlocks;
+  auto forEachBlock = [&](unsigned int startX, unsigned int endX,
+                          auto &&visit) {
+    for (unsigned int x = startX; x < endX; x++)
       for (unsigned int y = 0; y < parameters.gridHeight; y++)
         for (unsigned int z = 0; z < parameters.gridLength; z++) {
-          const auto &cell = grid[x][y][z];
-          if (!cell.collapsed || cell.blockTypeIds.empty())
-            continue;
-          for (size_t i = 0; i < cell.blockTypeIds.size(); i++) {
-            if (i >= cell.blockPositions.size())
-              continue;
-            int rotation =
-                (i < cell.blockRotations.size()) ? cell.blockRotations[i] : 0;
-            threadBlocks[threadId].emplace_back(
-                cell.blockTypeIds[i], cell.blockPositions[i], rotation);
-            if (controller && controller->GetBlockUI()) {
-              auto assets = controller->GetBlockUI()->GetLoadedAssets();
-              for (const auto &asset : assets) {
-                if (asset.id == cell.blockTypeIds[i] && asset.model) {
-                  for (auto *mesh : asset.model->getMeshes())
-                    if (mesh)
-                      for (auto &texture : mesh->textures)
-                        threadTextures[threadId].insert(texture);
-                  break;
-                }
-              }
-            }
-          }
+          int cell = wave.Index(x, y, z);
+          int chosen = wave.Chosen(cell);
+          if (chosen >= 0)
+            visit(x, y, z, chosen * 2 + (cullInterior && isEnclosed(cell)));
         }
-    }
   };
 
-  unsigned int chunkSize = parameters.gridWidth / numThreads,
-               remainder = parameters.gridWidth % numThreads, startX = 0;
-  std::vector<std::thread> workers;
-  for (unsigned int t = 0; t < numThreads; ++t) {
-    unsigned int endX = startX + chunkSize + (t < remainder ? 1 : 0);
-    workers.emplace_back(meshWorker, t, startX, endX);
-    startX = endX;
-  }
-  for (auto &th : workers)
-    th.join();
-
-  for (unsigned int t = 0; t < numThreads; ++t) {
-    for (const auto &block : threadBlocks[t]) {
-      int blockId;
-      glm::vec3 pos;
-      int rot;
-      std::tie(blockId, pos, rot) = block;
-      addBlockToMesh(blockMesh, blockId, pos, rot);
+  // First pass: how many blocks of each bucket every slab holds
+  std::vector<std::vector<size_t>> counts(
+      numThreads, std::vector<size_t>(variantCount * 2));
+  forEachSlab([&](unsigned int t, unsigned int startX, unsigned int endX) {
+    forEachBlock(startX, endX, [&](unsigned int, unsigned int, unsigned int,
+                                   int bucket) { counts[t][bucket]++; });
+  });
+
+  // Each model's instance array grows once. A slab's blocks of one bucket
+  // get their own run of it, so the second pass writes without locking.
+  std::map<std::string, std::vector<int>> variantsByPath;
+  std::map<int, std::vector<int>> variantsById;
+  for (int v = 0; v < variantCount; ++v) {
+    int blockId = adjacencyRules.GetVariant(v).blockId;
+    if (const auto *asset = assets->Find(blockId))
+      variantsByPath[asset->path].push_back(v);
+    else if (blockId >= 0)
+      variantsById[blockId].push_back(v);
+  }
+  std::vector<std::vector<glm::mat4 *>> cursors(
+      numThreads, std::vector<glm::mat4 *>(variantCount * 2, nullptr));
+  auto allocate = [&](const std::vector<int> &variants, int interior,
+                      auto &&grow) {
+    size_t total = 0;
+    for (unsigned int t = 0; t < numThreads; ++t)
+      for (int v : variants)
+        total += counts[t][v * 2 + interior];
+    glm::mat4 *slot = nullptr;
+    if (total == 0 || !(slot = grow(total)))
+      return;
+    for (unsigned int t = 0; t < numThreads; ++t)
+      for (int v : variants) {
+        cursors[t][v * 2 + interior] = slot;
+        slot += counts[t][v * 2 + interior];
+      }
+  };
+  for (const auto &entry : variantsByPath) {
+    const std::string &path = entry.first;
+    allocate(entry.second, 0, [&](size_t count) {
+      return blockMesh->AddBlockInstances(path, count);
+    });
+    if (settings.exportInteriorBlocks)
+      allocate(entry.second, 1, [&](size_t count) {
+        return blockMesh->AddInteriorInstances(path, count);
+      });
+  }
+  for (const auto &entry : variantsById) {
+    int blockId = entry.first;
+    allocate(entry.second, 0, [&](size_t count) {
+      return blockMesh->AddBlockInstances(blockId, count);
+    });
+  }
+
+  // Rotation and scale depend only on the variant and which of its
+  // equivalent rotations the cell was collapsed in; only the translation
+  // column changes per cell
+  std::vector<size_t> basisStart(variantCount + 1, 0);
+  for (int v = 0; v < variantCount; ++v)
+    basisStart[v + 1] =
+        basisStart[v] + adjacencyRules.GetVariant(v).rotations.size();
+  std::vector<glm::mat4> basis(basisStart[variantCount]);
+  for (int v = 0; v < variantCount; ++v) {
+    const auto &rotations = adjacencyRules.GetVariant(v).rotations;
+    for (size_t i = 0; i < rotations.size(); ++i) {
+      float angle = glm::radians(static_cast<float>(rotations[i]));
+      basis[basisStart[v] + i] = glm::scale(
+          glm::rotate(glm::mat4(1.0f), angle, glm::vec3(0.0f, 1.0f, 0.0f)),
+          glm::vec3(parameters.blockScale));
     }
   }
-  return blockMesh;
-}
 
-void BlockGenerator::addBlockToMesh(BlockMesh *blockMesh, int blockId,
-                                    const glm::vec3 &position, int rotation) {
-  if (blockId < 0)
-    return;
-  Transform blockTransform;
-  blockTransform.setPosition(position);
-  blockTransform.setScale(parameters.blockScale);
-  blockTransform.setRotation(
-      glm::vec3(0.0f, static_cast<float>(rotation), 0.0f));
-  if (controller && controller->GetBlockUI()) {
-    auto assets = controller->GetBlockUI()->GetLoadedAssets();
-    for (const auto &asset : assets) {
-      if (asset.id == blockId) {
-        blockMesh->AddBlockInstance(asset.blockPath, blockTransform);
+  forEachSlab([&](unsigned int t, unsigned int startX, unsigned int endX) {
+    forEachBlock(startX, endX, [&](unsigned int x, unsigned int y,
+                                   unsigned int z, int bucket) {
+      glm::mat4 *&slot = cursors[t][bucket];
+      if (!slot)
         return;
-      }
-    }
-  }
-  blockMesh->AddBlockInstance(blockId, blockTransform);
+      int v = bucket / 2;
+      int cell = wave.Index(x, y, z);
+      glm::mat4 matrix = basis[basisStart[v] + cellRotation[cell]];
+      matrix[3] = glm::vec4(calculateBlockPosition(x, y, z), 1.0f);
+      *slot++ = matrix;
+    });
+  });
+
+  if (cullInterior) {
+    size_t enclosed = 0;
+    for (const auto &slab : counts)
+      for (int v = 0; v < variantCount; ++v)
+        enclosed += slab[v * 2 + 1];
+    std::cout << "Interior blocks culled: " << enclosed << std::endl;
+  }
+  if (settings.bakeStaticBatches)
+    blockMesh->BakeStaticBatches(
+        static_cast<size_t>(std::max(1, settings.staticBatchVertices)));
+  else if (settings.multiDrawIndirect)
+    blockMesh->BuildIndirectBatch();
+  return blockMesh;
 }
 
 bool BlockGenerator::isValidGridPosition(int x, int y, int z) const {
@@ -501,16 +630,12 @@ BlockMesh *BlockGenerator::createEmptyMesh() {
 void BlockGenerator::initializeBlockWeights() {
   auto &settings = parameters.generationSettings;
   settings.currentBlockCounts.clear();
-  if (controller && controller->GetBlockUI()) {
-    auto assets = controller->GetBlockUI()->GetLoadedAssets();
-    for (const auto &asset : assets) {
-      if (settings.blockWeights.find(asset.id) == settings.blockWeights.end())
-        settings.blockWeights[asset.id] = settings.defaultWeight;
-      if (settings.maxBlockCounts.find(asset.id) ==
-          settings.maxBlockCounts.end())
-        settings.maxBlockCounts[asset.id] = -1;
-      settings.currentBlockCounts[asset.id] = 0;
-    }
+  for (const auto &asset : assets->Entries()) {
+    if (settings.blockWeights.find(asset.id) == settings.blockWeights.end())
+      settings.blockWeights[asset.id] = settings.defaultWeight;
+    if (settings.maxBlockCounts.find(asset.id) == settings.maxBlockCounts.end())
+      settings.maxBlockCounts[asset.id] = -1;
+    settings.currentBlockCounts[asset.id] = 0;
   }
 }
 
@@ -518,17 +643,50 @@ void BlockGenerator::resetBlockCounts() {
   auto &settings = parameters.generationSettings;
   for (auto &[blockId, count] : settings.currentBlockCounts)
     count = 0;
-}
 
-void BlockGenerator::resetGridForRestart() {
-  // Clear the grid and reinitialize it for a fresh start
-  grid.clear();
+  // Counts live in a dense table while solving and are copied back into
+  // currentBlockCounts by publishBlockCounts()
+  int idLimit = 0;
+  for (int v = 0; v < adjacencyRules.VariantCount(); ++v)
+    idLimit = std::max(idLimit, adjacencyRules.GetVariant(v).blockId + 1);
+  for (const auto *limits :
+       {&settings.minBlockCounts, &settings.maxBlockCounts})
+    if (!limits->empty())
+      idLimit = std::max(idLimit, limits->rbegin()->first + 1);
+  blockCounter.Reset(idLimit);
+  for (int blockId = 0; blockId < idLimit; ++blockId) {
+    auto minIt = settings.minBlockCounts.find(blockId);
+    auto maxIt = settings.maxBlockCounts.find(blockId);
+    blockCounter.SetLimits(
+        blockId, minIt != settings.minBlockCounts.end() ? minIt->second : 0,
+        maxIt != settings.maxBlockCounts.end() ? maxIt->second : -1,
+        settings.cornerBlockIds.count(blockId) > 0);
+  }
+
+  std::vector<int> variantBlocks(adjacencyRules.VariantCount());
+  for (int v = 0; v < adjacencyRules.VariantCount(); ++v)
+    variantBlocks[v] = adjacencyRules.GetVariant(v).blockId;
+  blockCounter.SetVariants(variantBlocks, adjacencyRules.WordCount());
+
+  // Collapse scratch, indexed by block id like the counter's tables
+  blockPickWeight.assign(idLimit, 1.0);
+  for (const auto &[blockId, weight] : settings.blockWeights)
+    if (blockId >= 0 && blockId < idLimit)
+      blockPickWeight[blockId] = std::max(weight, 0.0f);
+  blockStamp.assign(idLimit, 0);
+  blockVariantCount.assign(idLimit, 0);
+  blockPriority.assign(idLimit, 0);
+  collapseStamp = 0;
+}
 
-  // Clear propagation data structures
-  while (!propagationFringe.empty())
-    propagationFringe.pop();
-  duplicateSet.clear();
+void BlockGenerator::publishBlockCounts() {
+  auto &counts = parameters.generationSettings.currentBlockCounts;
+  for (int blockId = 0; blockId < blockCounter.IdLimit(); ++blockId)
+    if (blockCounter.Count(blockId) > 0 || counts.count(blockId))
+      counts[blockId] = blockCounter.Count(blockId);
+}
 
+void BlockGenerator::resetGridForRestart() {
   // Reinitialize the grid with fresh possibilities
   initializeGrid();
 
@@ -536,93 +694,32 @@ void BlockGenerator::resetGridForRestart() {
 }
 
 bool BlockGenerator::canPlaceBlock(int blockId) const {
-  auto &settings = parameters.generationSettings;
-
-  // Skip corner blocks - they use special placement logic
-  if (settings.cornerBlockIds.count(blockId) > 0) {
-    return true;
-  }
-
-  auto maxIt = settings.maxBlockCounts.find(blockId);
-  auto currentIt = settings.currentBlockCounts.find(blockId);
-  int currentCount =
-      (currentIt != settings.currentBlockCounts.end()) ? currentIt->second : 0;
-  bool isUnlimited =
-      (maxIt == settings.maxBlockCounts.end() || maxIt->second == -1);
-
-  // If unlimited, no max constraint, otherwise check max limit
-  if (!isUnlimited && currentCount >= maxIt->second) {
-    return false;
-  }
-
-  return true;
+  // Corner blocks are exempt; they use special placement logic
+  return blockCounter.CanPlace(blockId);
 }
 
 std::vector<int> BlockGenerator::getAvailableBlocks() const {
   std::vector<int> available;
-  if (controller && controller->GetBlockUI()) {
-    auto assets = controller->GetBlockUI()->GetLoadedAssets();
-    for (const auto &asset : assets)
-      if (canPlaceBlock(asset.id))
-        available.push_back(asset.id);
-  }
+  for (const auto &asset : assets->Entries())
+    if (canPlaceBlock(asset.id))
+      available.push_back(asset.id);
   return available;
 }
 
 bool BlockGenerator::hasReachedLimit(int blockId) const {
-  auto &settings = parameters.generationSettings;
-  auto maxIt = settings.maxBlockCounts.find(blockId);
-  auto currentIt = settings.currentBlockCounts.find(blockId);
-  if (maxIt == settings.maxBlockCounts.end() || maxIt->second == -1)
-    return false;
-  int currentCount =
-      (currentIt != settings.currentBlockCounts.end()) ? currentIt->second : 0;
-  return currentCount >= maxIt->second;
+  return blockCounter.Remaining(blockId) <= 0;
 }
 
 bool BlockGenerator::hasMetMinimumRequirements() const {
-  auto &settings = parameters.generationSettings;
-
-  for (const auto &[blockId, minCount] : settings.minBlockCounts) {
-    // Skip corner blocks - they use special placement logic
-    if (settings.cornerBlockIds.count(blockId) > 0) {
-      continue;
-    }
-
-    auto currentIt = settings.currentBlockCounts.find(blockId);
-    int currentCount = (currentIt != settings.currentBlockCounts.end())
-                           ? currentIt->second
-                           : 0;
-
-    if (currentCount < minCount) {
-      return false;
-    }
-  }
-
-  return true;
+  return blockCounter.MinimumsMet();
 }
 
-std::vector<int> BlockGenerator::getBlocksNeedingMinCount() const {
-  auto &settings = parameters.generationSettings;
-  std::vector<int> blocksNeeded;
-
-  for (const auto &[blockId, minCount] : settings.minBlockCounts) {
-    // Skip corner blocks - they use special placement logic
-    if (settings.cornerBlockIds.count(blockId) > 0) {
-      continue;
-    }
-
-    auto currentIt = settings.currentBlockCounts.find(blockId);
-    int currentCount = (currentIt != settings.currentBlockCounts.end())
-                           ? currentIt->second
-                           : 0;
-
-    if (currentCount < minCount && canPlaceBlock(blockId)) {
-      blocksNeeded.push_back(blockId);
-    }
-  }
+bool BlockGenerator::needsMinCount(int blockId) const {
+  return blockCounter.NeedsMin(blockId);
+}
 
-  return blocksNeeded;
+const std::vector<int> &BlockGenerator::getBlocksNeedingMinCount() const {
+  return blockCounter.Deficits();
 }
 
 int BlockGenerator::getFaceIndex(const std::string &faceDirection) {
@@ -644,50 +741,14 @@ int BlockGenerator::getOppositeFaceIndex(int faceIndex) {
 }
 
 void BlockGenerator::generateRectangularCastle(std::mt19937 &rng) {
-  // const int maxRestarts = 10; // Maximum number of hard restarts allowed
-  // int restartCount = 0;
-
+  // Contradictions are undone by backtracking inside the attempt, so the
+  // grid is never thrown away and rebuilt from scratch
   attemptRectangularCastleGeneration(rng);
-
-  // while (restartCount < maxRestarts) {
-  //     std::cout << "Rectangular Castle Generation attempt " << (restartCount
-  //     + 1) << "/" << maxRestarts << std::endl;
-
-  //     // Reset grid state for fresh attempt
-  //     if (restartCount > 0) {
-  //         resetGridForRestart();
-  //         resetBlockCounts();
-  //     }
-
-  //     bool success = attemptRectangularCastleGeneration(rng);
-
-  //     if (success && !hasContradictions()) {
-  //         std::cout << "Rectangular Castle Generation completed successfully
-  //         on attempt " << (restartCount + 1) << std::endl; return;
-  //     }
-
-  //     if (hasContradictions()) {
-  //         std::cout << "Contradictions detected in castle generation on
-  //         attempt " << (restartCount + 1) << ", performing hard restart..."
-  //         << std::endl;
-  //     } else {
-  //         std::cout << "Castle generation failed on attempt " <<
-  //         (restartCount + 1) << ", performing hard restart..." << std::endl;
-  //     }
-
-  //     restartCount++;
-
-  //     // Use a different random seed for each restart to get different
-  //     results rng.seed(parameters.randomSeed + restartCount * 1000);
-  // }
-
-  // std::cerr << "Rectangular Castle Generation failed after " << maxRestarts
-  // << " attempts. Using partial result." << std::endl;
 }
 
 bool BlockGenerator::attemptRectangularCastleGeneration(std::mt19937 &rng) {
-  // Initialize the grid mask for rectangular castle generation
-  initializeGridMask();
+  // The grid mask is set up by initializeGrid() so masked cells are blocked
+  // out of the wave before any propagation happens
 
   // Find the first corner position to start generation
   GridPosition cornerStart = findFirstCornerPosition();
@@ -701,82 +762,59 @@ bool BlockGenerator::attemptRectangularCastleGeneration(std::mt19937 &rng) {
   }
 
   // Use frontier-based WFC for the rest of the generation, but respect the grid
-  // mask
-  std::priority_queue<FrontierCell, std::vector<FrontierCell>, std::greater<>>
-      frontier;
-  std::set<GridPosition> inFrontier;
-
+  // mask. The frontier lives in the wave and stays keyed by current entropy.
   // Add neighbors of the initial corner to the frontier
-  const std::vector<std::tuple<int, int, int>> neighborOffsets = {
-      {1, 0, 0}, {-1, 0, 0}, {0, 1, 0}, {0, -1, 0}, {0, 0, 1}, {0, 0, -1}};
-
-  for (const auto &[dx, dy, dz] : neighborOffsets) {
-    int nx = cornerStart.x + dx, ny = cornerStart.y + dy,
-        nz = cornerStart.z + dz;
-    if (isValidGridPosition(nx, ny, nz) && !isGridCellMasked(nx, ny, nz) &&
-        !grid[nx][ny][nz].collapsed) {
-      double entropy = calculateCellEntropy(grid[nx][ny][nz]);
-      frontier.push({entropy, {nx, ny, nz}});
-      inFrontier.insert({nx, ny, nz});
-    }
-  }
+  auto openNeighbors = [&](int cell) {
+    wave.ForEachNeighbor(cell, [&](int, int neighbor) {
+      int nx, ny, nz;
+      wave.Position(neighbor, nx, ny, nz);
+      if (!isGridCellMasked(nx, ny, nz) && !wave.IsCollapsed(neighbor) &&
+          !wave.IsOpen(neighbor))
+        wave.Open(neighbor);
+    });
+  };
+  openNeighbors(wave.Index(cornerStart.x, cornerStart.y, cornerStart.z));
 
   // Main generation loop
-  while (!frontier.empty()) {
-    FrontierCell fc = frontier.top();
-    frontier.pop();
+  while (wave.HasOpen() && !shouldStop()) {
+    size_t mark = wave.JournalMark();
+    GridPosition pos;
+    int index = wave.PopLowestEntropy();
+    wave.Position(index, pos.x, pos.y, pos.z);
 
     // Skip if cell is masked or already collapsed
-    if (isGridCellMasked(fc.pos.x, fc.pos.y, fc.pos.z) ||
-        grid[fc.pos.x][fc.pos.y][fc.pos.z].collapsed) {
-      inFrontier.erase(fc.pos);
+    if (isGridCellMasked(pos.x, pos.y, pos.z) ||
+        wave.IsCollapsed(wave.Index(pos.x, pos.y, pos.z))) {
       continue;
     }
 
-    auto &cell = grid[fc.pos.x][fc.pos.y][fc.pos.z];
-    if (cell.possibleBlockRotationPairs.empty()) {
-      inFrontier.erase(fc.pos);
+    if (wave.IsEmpty(wave.Index(pos.x, pos.y, pos.z))) {
       continue;
     }
 
     // Collapse the cell (use corner block if it's a corner position)
     bool success = false;
-    if (isCornerPosition(fc.pos.x, fc.pos.y, fc.pos.z)) {
-      success = tryPlaceCornerBlock(fc.pos.x, fc.pos.y, fc.pos.z, rng);
+    if (isCornerPosition(pos.x, pos.y, pos.z)) {
+      success = tryPlaceCornerBlock(pos.x, pos.y, pos.z, rng);
     } else {
-      success = collapseCellWFC(fc.pos.x, fc.pos.y, fc.pos.z, rng);
+      success = collapseCellWFC(pos.x, pos.y, pos.z, rng);
     }
 
     if (!success) {
-      inFrontier.erase(fc.pos);
+      resolveContradiction();
       continue;
     }
-
-    inFrontier.erase(fc.pos);
+    pushDecision(mark, index);
+    if (resolveContradiction())
+      continue;
 
     // Add neighbors to frontier
-    for (const auto &[dx, dy, dz] : neighborOffsets) {
-      int nx = fc.pos.x + dx, ny = fc.pos.y + dy, nz = fc.pos.z + dz;
-      GridPosition npos{nx, ny, nz};
-
-      if (isValidGridPosition(nx, ny, nz) && !isGridCellMasked(nx, ny, nz) &&
-          !grid[nx][ny][nz].collapsed &&
-          inFrontier.find(npos) == inFrontier.end()) {
-        double entropy = calculateCellEntropy(grid[nx][ny][nz]);
-        frontier.push({entropy, {nx, ny, nz}});
-        inFrontier.insert({nx, ny, nz});
-      }
-    }
+    openNeighbors(index);
   }
   return true; // Successfully completed generation
 }
 
 void BlockGenerator::initializeGridMask() {
-  gridMask.assign(parameters.gridWidth,
-                  std::vector<std::vector<bool>>(
-                      parameters.gridHeight,
-                      std::vector<bool>(parameters.gridLength, false)));
-
   // Create a hollow rectangle pattern
   // Only the perimeter of the rectangle should be unmasked (allowed for
   // generation)
@@ -788,7 +826,8 @@ void BlockGenerator::initializeGridMask() {
                            (z == 0 || z == parameters.gridLength - 1);
 
         // Unmask (allow generation) only on the perimeter
-        gridMask[x][y][z] = !isPerimeter;
+        if (!isPerimeter)
+          wave.Block(wave.Index(x, y, z));
       }
     }
   }
@@ -797,7 +836,7 @@ void BlockGenerator::initializeGridMask() {
 bool BlockGenerator::isGridCellMasked(int x, int y, int z) const {
   if (!isValidGridPosition(x, y, z))
     return true;
-  return gridMask[x][y][z];
+  return wave.IsBlocked(wave.Index(x, y, z));
 }
 
 bool BlockGenerator::isCornerPosition(int x, int y, int z) const {
@@ -831,8 +870,7 @@ bool BlockGenerator::tryPlaceCornerBlock(int x, int y, int z,
   if (!isValidGridPosition(x, y, z))
     return false;
 
-  auto &cell = grid[x][y][z];
-  if (cell.collapsed)
+  if (wave.IsCollapsed(wave.Index(x, y, z)))
     return false;
 
   // Get available corner blocks
@@ -865,12 +903,9 @@ bool BlockGenerator::tryPlaceCornerBlock(int x, int y, int z,
     // Try to find the best rotation for this corner block
     int bestRotation = findBestCornerRotation(x, y, z, cornerBlockId);
     if (bestRotation != -1) {
-      cell.collapsed = true;
-      cell.possibleBlockRotationPairs = {{cornerBlockId, bestRotation}};
-      cell.blockTypeIds = {cornerBlockId};
-      cell.blockRotations = {bestRotation};
-      glm::vec3 blockPosition = calculateBlockPosition(x, y, z);
-      cell.blockPositions = {blockPosition};
+      int variant = adjacencyRules.FindVariant(cornerBlockId, bestRotation);
+      wave.Assign(wave.Index(x, y, z), variant);
+      cellRotation[wave.Index(x, y, z)] = rotationSlot(variant, bestRotation);
       incrementBlockCount(cornerBlockId);
 
       // Reset the first block flag after placing the initial corner
@@ -1123,8 +1158,22 @@ std::vector<int> BlockGenerator::getCornerBlocks() const {
 }
 
 void BlockGenerator::incrementBlockCount(int blockId) {
-  auto &settings = parameters.generationSettings;
-  settings.currentBlockCounts[blockId]++;
+  int change = blockCounter.Add(blockId, 1);
+
+  // A block at its maximum leaves the whole frontier at once. Cells the
+  // solve has not reached yet drop it when they are validated; banning it
+  // from every cell costs more than the solve on large grids.
+  if (change & BlockCounter::kSaturation)
+    wave.BanOpen(blockCounter.SaturatedMask());
+  // Only this block's min-count boost can have changed
+  if (change & BlockCounter::kDeficit)
+    refreshVariantWeights();
+}
+
+void BlockGenerator::decrementBlockCount(int blockId) {
+  // Bans made when the block saturated are undone by the same rollback
+  if (blockCounter.Add(blockId, -1) & BlockCounter::kDeficit)
+    refreshVariantWeights();
 }
 
 bool BlockGenerator::shouldPrioritizeMinCountBlock(int x, int y, int z,
@@ -1132,9 +1181,7 @@ bool BlockGenerator::shouldPrioritizeMinCountBlock(int x, int y, int z,
   auto &settings = parameters.generationSettings;
 
   // Check if this block needs minimum count
-  auto blocksNeeded = getBlocksNeedingMinCount();
-  if (std::find(blocksNeeded.begin(), blocksNeeded.end(), blockId) ==
-      blocksNeeded.end()) {
+  if (!needsMinCount(blockId)) {
     return false; // Block doesn't need more placement
   }
 
@@ -1146,12 +1193,12 @@ bool BlockGenerator::shouldPrioritizeMinCountBlock(int x, int y, int z,
     for (int dy = -searchRadius; dy <= searchRadius; dy++) {
       for (int dz = -searchRadius; dz <= searchRadius; dz++) {
         int nx = x + dx, ny = y + dy, nz = z + dz;
-        if (isValidGridPosition(nx, ny, nz) && grid[nx][ny][nz].collapsed) {
-          for (int placedBlockId : grid[nx][ny][nz].blockTypeIds) {
-            if (placedBlockId == blockId) {
-              nearbyCount++;
-            }
-          }
+        if (!isValidGridPosition(nx, ny, nz))
+          continue;
+        int placed = wave.Chosen(wave.Index(nx, ny, nz));
+        if (placed >= 0 &&
+            adjacencyRules.GetVariant(placed).blockId == blockId) {
+          nearbyCount++;
         }
       }
     }
@@ -1164,195 +1211,196 @@ bool BlockGenerator::collapseCellWFC(int x, int y, int z, std::mt19937 &rng) {
   if (!isValidGridPosition(x, y, z))
     return false;
 
-  auto &cell = grid[x][y][z];
-  if (cell.collapsed)
+  int index = wave.Index(x, y, z);
+  if (wave.IsCollapsed(index))
     return true;
 
   validateCellPossibilitySpace(x, y, z);
 
-  if (cell.possibleBlockRotationPairs.empty()) {
+  if (wave.IsEmpty(index)) {
     return false;
   }
 
-  // Use weighted selection for block choice
-  std::vector<std::pair<int, int>> priorityPairs;
-  auto blocksNeeded = getBlocksNeedingMinCount();
-
-  // Check for blocks that need minimum count
-  for (const auto &pair : cell.possibleBlockRotationPairs) {
-    int blockId = pair.first;
-    if (std::find(blocksNeeded.begin(), blocksNeeded.end(), blockId) !=
-        blocksNeeded.end()) {
-      if (shouldPrioritizeMinCountBlock(x, y, z, blockId)) {
-        priorityPairs.push_back(pair);
-      }
+  // Per-block tallies over the domain; stamping them saves clearing the
+  // tables between collapses
+  ++collapseStamp;
+  bool anyPriority = false;
+  const uint64_t *domain = wave.Domain(index);
+  WFC::ForEachBit(domain, wave.WordCount(), [&](int variant) {
+    int blockId = adjacencyRules.GetVariant(variant).blockId;
+    if (blockStamp[blockId] != collapseStamp) {
+      blockStamp[blockId] = collapseStamp;
+      blockVariantCount[blockId] = 0;
+      // Blocks that need a minimum count take precedence when present
+      blockPriority[blockId] = shouldPrioritizeMinCountBlock(x, y, z, blockId);
+      anyPriority |= blockPriority[blockId] != 0;
     }
-  }
-
-  // Use priority pairs if available, otherwise use all possibilities
-  auto &finalPairs =
-      priorityPairs.empty() ? cell.possibleBlockRotationPairs : priorityPairs;
-
-  // Select weighted pair
-  std::vector<int> uniqueBlocks;
-  std::map<int, std::vector<int>> blockToRotations;
-
-  // Group pairs by block ID
-  for (const auto &pair : finalPairs) {
-    int blockId = pair.first;
-    int rotation = pair.second;
-
-    if (blockToRotations.find(blockId) == blockToRotations.end()) {
-      uniqueBlocks.push_back(blockId);
-      blockToRotations[blockId] = std::vector<int>();
-    }
-    blockToRotations[blockId].push_back(rotation);
-  }
-
-  // Select block using weights
-  int chosenBlockId = selectWeightedBlock(uniqueBlocks, rng);
-
-  // Select random rotation for the chosen block
-  auto &availableRotations = blockToRotations[chosenBlockId];
-  std::uniform_int_distribution<size_t> rotDist(0,
-                                                availableRotations.size() - 1);
-  int chosenRotation = availableRotations[rotDist(rng)];
+    ++blockVariantCount[blockId];
+  });
+
+  // A block is drawn by its weight and then one of its variants uniformly,
+  // so each variant weighs its block's share. Without any positive weight
+  // the blocks are drawn uniformly instead.
+  auto weightOf = [&](int variant, bool uniform) {
+    int blockId = adjacencyRules.GetVariant(variant).blockId;
+    if ((anyPriority && !blockPriority[blockId]) || !canPlaceBlock(blockId))
+      return 0.0;
+    double weight = uniform ? 1.0 : blockPickWeight[blockId];
+    return weight / blockVariantCount[blockId];
+  };
+  auto totalOf = [&](bool uniform) {
+    double total = 0.0;
+    WFC::ForEachBit(domain, wave.WordCount(),
+                    [&](int variant) { total += weightOf(variant, uniform); });
+    return total;
+  };
+  double totalWeight = totalOf(false);
+  bool uniform = totalWeight <= 0.0;
+  if (uniform)
+    totalWeight = totalOf(true);
+  if (totalWeight <= 0.0)
+    return false;
 
-  std::pair<int, int> chosenPair = {chosenBlockId, chosenRotation};
+  std::uniform_real_distribution<double> dist(0.0, totalWeight);
+  double target = dist(rng), currentWeight = 0.0;
+  int chosenVariant = -1;
+  WFC::ForEachBit(domain, wave.WordCount(), [&](int variant) {
+    double weight = weightOf(variant, uniform);
+    if (weight <= 0.0 || (chosenVariant >= 0 && currentWeight >= target))
+      return;
+    currentWeight += weight;
+    chosenVariant = variant;
+  });
 
   // Collapse the cell
-  cell.collapsed = true;
-  cell.possibleBlockRotationPairs = {chosenPair};
-  cell.blockTypeIds = {chosenPair.first};
-  cell.blockRotations = {chosenPair.second};
-  glm::vec3 blockPosition = calculateBlockPosition(x, y, z);
-  cell.blockPositions = {blockPosition};
-  incrementBlockCount(chosenPair.first);
+  int chosenBlockId = adjacencyRules.GetVariant(chosenVariant).blockId;
+  wave.Assign(index, chosenVariant);
+  cellRotation[index] = drawRotation(chosenVariant, rng);
+  incrementBlockCount(chosenBlockId);
 
   return true;
 }
 
-void BlockGenerator::propagateWave(const GridPosition &startPos) {
-  std::vector<GridPosition> neighbors = getNeighborPositions(startPos);
-
-  // Add neighbors to fringe
-  for (const auto &neighbor : neighbors) {
-    propagationFringe.push(neighbor);
-  }
-
-  // Propagate changes until fringe is empty
-  while (!propagationFringe.empty()) {
-    GridPosition currentPos = propagationFringe.top();
-    propagationFringe.pop();
-
-    if (!isValidGridPosition(currentPos.x, currentPos.y, currentPos.z))
-      continue;
-
-    auto &cell = grid[currentPos.x][currentPos.y][currentPos.z];
-
-    // Validate possibility space - remove invalid block/rotation pairs
-    bool changed =
-        validateCellPossibilitySpace(currentPos.x, currentPos.y, currentPos.z);
-
-    // Remove from duplicate set since we processed it
-    duplicateSet.erase(currentPos);
-
-    // If cell has only one possibility and isn't collapsed, collapse it
-    // But be careful not to force collapse too early
-    if (cell.possibleBlockRotationPairs.size() == 1 && !cell.collapsed) {
-      auto chosenPair = cell.possibleBlockRotationPairs[0];
-      cell.collapsed = true;
-      cell.blockTypeIds = {chosenPair.first};
-      cell.blockRotations = {chosenPair.second};
-      glm::vec3 blockPosition =
-          calculateBlockPosition(currentPos.x, currentPos.y, currentPos.z);
-      cell.blockPositions = {blockPosition};
-      incrementBlockCount(chosenPair.first);
-
-      // Force propagate from newly collapsed cells
-      changed = true;
-    }
-
-    if (changed) {
-      std::vector<GridPosition> currentNeighbors =
-          getNeighborPositions(currentPos);
-      for (const auto &neighbor : currentNeighbors) {
-        if (!isValidGridPosition(neighbor.x, neighbor.y, neighbor.z))
-          continue;
-
-        auto &neighborCell = grid[neighbor.x][neighbor.y][neighbor.z];
-
-        if (!neighborCell.collapsed &&
-            duplicateSet.find(neighbor) == duplicateSet.end()) {
-          propagationFringe.push(neighbor);
-          duplicateSet.insert(neighbor);
-        }
-      }
-    }
-  }
-
-  // Clear duplicate set after wave propagation
-  duplicateSet.clear();
+uint8_t BlockGenerator::drawRotation(int variant, std::mt19937 &rng) {
+  // The solver never tells equivalent rotations apart, so a collapsed cell
+  // draws the one it is shown in; most variants have no choice to make
+  size_t choices = adjacencyRules.GetVariant(variant).rotations.size();
+  if (choices < 2)
+    return 0;
+  std::uniform_int_distribution<size_t> dist(0, choices - 1);
+  return static_cast<uint8_t>(dist(rng));
 }
 
-std::vector<GridPosition>
-BlockGenerator::getNeighborPositions(const GridPosition &pos) const {
-  std::vector<GridPosition> neighbors;
-
-  const std::vector<std::tuple<int, int, int>> offsets = {
-      {1, 0, 0}, {-1, 0, 0}, {0, 1, 0}, {0, -1, 0}, {0, 0, 1}, {0, 0, -1}};
+uint8_t BlockGenerator::rotationSlot(int variant, int rotation) const {
+  const auto &rotations = adjacencyRules.GetVariant(variant).rotations;
+  auto it = std::find(rotations.begin(), rotations.end(), rotation);
+  return it != rotations.end() ? static_cast<uint8_t>(it - rotations.begin())
+                               : 0;
+}
 
-  for (const auto &[dx, dy, dz] : offsets) {
-    int nx = pos.x + dx;
-    int ny = pos.y + dy;
-    int nz = pos.z + dz;
+void BlockGenerator::propagateWave(const GridPosition &startPos) {
+  // Adjacency removals are already propagated by the wave itself; what is
+  // left is the generator-side work for every cell whose domain shrank:
+  // the block count limits and collapsing cells down to one possibility.
+  int index;
+  while ((index = wave.PopDirty()) >= 0) {
+    int x, y, z;
+    wave.Position(index, x, y, z);
+    if (wave.IsCollapsed(index))
+      continue;
 
-    if (isValidGridPosition(nx, ny, nz)) {
-      neighbors.push_back({nx, ny, nz});
+    validateCellPossibilitySpace(x, y, z);
+
+    // If cell has only one possibility and isn't collapsed, collapse it. A
+    // variant that stands for several rotations still leaves a choice, so
+    // that cell waits for the frontier like before rotations were merged.
+    int single = wave.SingleVariant(index);
+    if (single >= 0 && adjacencyRules.GetVariant(single).rotations.size() < 2) {
+      const auto &variant = adjacencyRules.GetVariant(single);
+      // Collapsing drops the cell's hole support, which queues its
+      // neighbours again if that narrows them
+      wave.Assign(index, single);
+      cellRotation[index] = 0;
+      incrementBlockCount(variant.blockId);
     }
   }
-
-  return neighbors;
 }
 
 bool BlockGenerator::validateCellPossibilitySpace(int x, int y, int z) {
-  auto &cell = grid[x][y][z];
-  if (cell.collapsed)
+  int index = wave.Index(x, y, z);
+  if (wave.IsCollapsed(index))
     return false;
 
-  std::vector<std::pair<int, int>> validPairs;
+  // Adjacency is kept current by the wave's support counters, and
+  // saturated blocks leave the frontier when they fill up; cells opened
+  // since then are caught by one mask test here
+  const uint64_t *saturated = blockCounter.SaturatedMask();
+  if (!WFC::Intersects(wave.Domain(index), saturated, wave.WordCount()))
+    return false;
+  wave.BanIf(index,
+             [&](int variant) { return WFC::TestBit(saturated, variant); });
+  return true;
+}
 
-  for (const auto &pair : cell.possibleBlockRotationPairs) {
-    int blockId = pair.first;
-    int rotation = pair.second;
+void BlockGenerator::resetDecisions() {
+  auto &settings = parameters.generationSettings;
+  decisions.clear();
+  backtracksLeft = settings.maxBacktracks;
+  wave.SetJournaling(settings.backtrackDepth > 0 && backtracksLeft > 0);
+}
 
-    if (!canPlaceBlock(blockId))
-      continue;
+void BlockGenerator::pushDecision(size_t mark, int cell) {
+  int depth = parameters.generationSettings.backtrackDepth;
+  if (depth <= 0 || backtracksLeft <= 0)
+    return;
 
-    // Use the existing validation method
-    if (isBlockValidAtPosition(x, y, z, blockId, rotation)) {
-      validPairs.push_back(pair);
-    }
+  // Only the most recent decisions can be undone; older ones become final
+  decisions.emplace_back(mark, cell);
+  if (static_cast<int>(decisions.size()) > depth) {
+    decisions.erase(decisions.begin());
+    wave.CommitJournal(decisions.front().first);
   }
+}
 
-  bool changed = (validPairs.size() != cell.possibleBlockRotationPairs.size());
+bool BlockGenerator::resolveContradiction() {
+  if (!wave.HasContradiction())
+    return false;
 
-  cell.possibleBlockRotationPairs = validPairs;
+  bool undone = false;
+  while (!decisions.empty() && backtracksLeft > 0) {
+    auto [mark, cell] = decisions.back();
+    decisions.pop_back();
+    backtracksLeft--;
+    undone = true;
+
+    int variant = wave.Chosen(cell);
+    wave.Rollback(mark, [this](int, int undone) {
+      decrementBlockCount(adjacencyRules.GetVariant(undone).blockId);
+    });
+
+    // The cell is open again. Ruling out the failed choice is part of the
+    // parent decision, so undoing that one brings the choice back.
+    if (variant >= 0)
+      wave.Ban(cell, variant);
+    GridPosition pos;
+    wave.Position(cell, pos.x, pos.y, pos.z);
+    propagateWave(pos);
+    if (!wave.HasContradiction())
+      return true;
+  }
 
-  return changed;
+  // Out of decisions or budget: keep the dangling socket as a hole
+  if (backtracksLeft <= 0) {
+    decisions.clear();
+    wave.SetJournaling(false);
+  }
+  wave.ClearContradiction();
+  return undone;
 }
 
 bool BlockGenerator::runSingleWFCAttempt(std::mt19937 &rng) {
-  // Initialize frontier using true bottom-up approach
-  std::priority_queue<FrontierCell, std::vector<FrontierCell>, std::greater<>>
-      frontier;
-  std::set<GridPosition> inFrontier;
-
-  // Clear propagation data structures
-  while (!propagationFringe.empty())
-    propagationFringe.pop();
-  duplicateSet.clear();
-
+  // Initialize frontier using true bottom-up approach. Cells are opened in
+  // the wave with a height bias on top of their live entropy.
   // Start from the absolute bottom layer (y=0) and work upward
   int startY = 0;
 
@@ -1367,8 +1415,8 @@ bool BlockGenerator::runSingleWFCAttempt(std::mt19937 &rng) {
           continue;
         }
 
-        auto &cell = grid[x][y][z];
-        if (!cell.collapsed && !cell.possibleBlockRotationPairs.empty()) {
+        int index = wave.Index(x, y, z);
+        if (!wave.IsCollapsed(index) && !wave.IsEmpty(index)) {
           hasValidCells = true;
           break;
         }
@@ -1400,8 +1448,8 @@ bool BlockGenerator::runSingleWFCAttempt(std::mt19937 &rng) {
         continue;
       }
 
-      auto &cell = grid[x][startY][z];
-      if (!cell.collapsed && !cell.possibleBlockRotationPairs.empty()) {
+      int index = wave.Index(x, startY, z);
+      if (!wave.IsCollapsed(index) && !wave.IsEmpty(index)) {
         potentialEntryPoints.push_back({x, startY, z});
       }
     }
@@ -1418,23 +1466,19 @@ bool BlockGenerator::runSingleWFCAttempt(std::mt19937 &rng) {
   // Place the first block unconditionally to guarantee a starting point
   if (!potentialEntryPoints.empty()) {
     GridPosition firstPos = potentialEntryPoints[0];
-    auto &firstCell = grid[firstPos.x][firstPos.y][firstPos.z];
 
     // Get all available block types
     std::vector<int> allBlocks;
-    if (controller && controller->GetBlockUI()) {
-      auto assets = controller->GetBlockUI()->GetLoadedAssets();
-      for (const auto &asset : assets) {
-        if (parameters.socketSystem.GetBlockTemplates().count(asset.id) > 0) {
-          // Get the block template for this asset
-          const auto &blockTemplate =
-              parameters.socketSystem.GetBlockTemplates().at(asset.id);
-
-          // Check if the -Y face (index 3) has a non-empty socket
-          if (!parameters.socketSystem.GetCompatibility().HasRule(
-                  blockTemplate.sockets[3].type)) {
-            allBlocks.push_back(asset.id);
-          }
+    for (const auto &asset : assets->Entries()) {
+      if (parameters.socketSystem.GetBlockTemplates().count(asset.id) > 0) {
+        // Get the block template for this asset
+        const auto &blockTemplate =
+            parameters.socketSystem.GetBlockTemplates().at(asset.id);
+
+        // Check if the -Y face (index 3) has a non-empty socket
+        if (!parameters.socketSystem.GetCompatibility().HasRule(
+                blockTemplate.sockets[3].type)) {
+          allBlocks.push_back(asset.id);
         }
       }
     }
@@ -1454,14 +1498,10 @@ bool BlockGenerator::runSingleWFCAttempt(std::mt19937 &rng) {
         int randomRotation = templateIt->second.allowedRotations[rotDist(rng)];
 
         // Place the block unconditionally
-        firstCell.collapsed = true;
-        firstCell.possibleBlockRotationPairs = {
-            {randomBlockId, randomRotation}};
-        firstCell.blockTypeIds = {randomBlockId};
-        firstCell.blockRotations = {randomRotation};
-        glm::vec3 blockPosition =
-            calculateBlockPosition(firstPos.x, firstPos.y, firstPos.z);
-        firstCell.blockPositions = {blockPosition};
+        int cell = wave.Index(firstPos.x, firstPos.y, firstPos.z);
+        int variant = adjacencyRules.FindVariant(randomBlockId, randomRotation);
+        wave.Assign(cell, variant);
+        cellRotation[cell] = rotationSlot(variant, randomRotation);
         incrementBlockCount(randomBlockId);
 
         std::cout << "Placed first block unconditionally: Block "
@@ -1473,29 +1513,18 @@ bool BlockGenerator::runSingleWFCAttempt(std::mt19937 &rng) {
         propagateWave(firstPos);
 
         // Add neighbors to frontier
-        const std::vector<std::tuple<int, int, int>> neighborOffsets = {
-            {1, 0, 0},  {-1, 0, 0}, {0, 1, 0},
-            {0, -1, 0}, {0, 0, 1},  {0, 0, -1}};
-
-        for (const auto &[dx, dy, dz] : neighborOffsets) {
-          int nx = firstPos.x + dx, ny = firstPos.y + dy, nz = firstPos.z + dz;
-          GridPosition npos{nx, ny, nz};
-
-          if (isValidGridPosition(nx, ny, nz) &&
-              !(parameters.generationSettings.isGridMaskEnabled &&
+        int firstCell = wave.Index(firstPos.x, firstPos.y, firstPos.z);
+        wave.ForEachNeighbor(firstCell, [&](int, int neighbor) {
+          int nx, ny, nz;
+          wave.Position(neighbor, nx, ny, nz);
+          if (!(parameters.generationSettings.isGridMaskEnabled &&
                 isGridCellMasked(nx, ny, nz)) &&
-              !grid[nx][ny][nz].collapsed &&
-              !grid[nx][ny][nz].possibleBlockRotationPairs.empty() &&
-              inFrontier.find(npos) == inFrontier.end()) {
-
-            double entropy = calculateCellEntropy(grid[nx][ny][nz]);
-            entropy += (ny * 0.1);
-
-            frontier.push({entropy, npos});
-            inFrontier.insert(npos);
+              !wave.IsCollapsed(neighbor) && !wave.IsEmpty(neighbor) &&
+              !wave.IsOpen(neighbor)) {
+            wave.Open(neighbor, ny * 0.1);
             entryPointsAdded++;
           }
-        }
+        });
       }
     }
   }
@@ -1507,18 +1536,13 @@ bool BlockGenerator::runSingleWFCAttempt(std::mt19937 &rng) {
     const auto &pos = potentialEntryPoints[i];
 
     // Skip if already processed or too close to existing entry points
-    if (inFrontier.find(pos) != inFrontier.end() ||
-        grid[pos.x][pos.y][pos.z].collapsed) {
+    int index = wave.Index(pos.x, pos.y, pos.z);
+    if (wave.IsOpen(index) || wave.IsCollapsed(index)) {
       continue;
     }
 
-    auto &cell = grid[pos.x][pos.y][pos.z];
-    if (!cell.possibleBlockRotationPairs.empty()) {
-      double entropy = calculateCellEntropy(cell);
-      entropy += (pos.y * 0.001);
-
-      frontier.push({entropy, pos});
-      inFrontier.insert(pos);
+    if (!wave.IsEmpty(index)) {
+      wave.Open(index, pos.y * 0.001);
       entryPointsAdded++;
     }
   }
@@ -1551,29 +1575,26 @@ bool BlockGenerator::runSingleWFCAttempt(std::mt19937 &rng) {
             << " out of " << totalValidCells << " total valid cells"
             << std::endl;
 
-  const std::vector<std::tuple<int, int, int>> neighborOffsets = {
-      {1, 0, 0}, {-1, 0, 0}, {0, 1, 0}, {0, -1, 0}, {0, 0, 1}, {0, 0, -1}};
-
   int iterationCount = 0;
   int consecutiveSkips = 0;
   const int maxConsecutiveSkips = 10;
   int totalCellsProcessed = 0;
   int failedCells = 0;
 
-  while (!frontier.empty()) {
-    FrontierCell fc = frontier.top();
-    frontier.pop();
+  while (wave.HasOpen() && !shouldStop()) {
+    size_t mark = wave.JournalMark();
+    GridPosition pos;
+    int index = wave.PopLowestEntropy();
+    wave.Position(index, pos.x, pos.y, pos.z);
     iterationCount++;
 
     // Skip if already processed or no longer valid
-    auto &cell = grid[fc.pos.x][fc.pos.y][fc.pos.z];
-    if (cell.collapsed || cell.possibleBlockRotationPairs.empty()) {
-      inFrontier.erase(fc.pos);
+    if (wave.IsCollapsed(index) || wave.IsEmpty(index)) {
       consecutiveSkips++;
 
       // If we've had too many skips and frontier is empty, try starting from a
       // new point
-      if (consecutiveSkips > maxConsecutiveSkips && frontier.empty()) {
+      if (consecutiveSkips > maxConsecutiveSkips && !wave.HasOpen()) {
         std::cout
             << "Frontier expansion complete - attempting new random start..."
             << std::endl;
@@ -1586,8 +1607,8 @@ bool BlockGenerator::runSingleWFCAttempt(std::mt19937 &rng) {
               if (isValidGridPosition(nx, ny, nz) &&
                   !(parameters.generationSettings.isGridMaskEnabled &&
                     isGridCellMasked(nx, ny, nz)) &&
-                  !grid[nx][ny][nz].collapsed &&
-                  !grid[nx][ny][nz].possibleBlockRotationPairs.empty()) {
+                  !wave.IsCollapsed(wave.Index(nx, ny, nz)) &&
+                  !wave.IsEmpty(wave.Index(nx, ny, nz))) {
 
                 potentialStarts.push_back({nx, ny, nz});
               }
@@ -1606,12 +1627,8 @@ bool BlockGenerator::runSingleWFCAttempt(std::mt19937 &rng) {
             if (newStartsAdded >= maxNewStarts)
               break;
 
-            double entropy =
-                calculateCellEntropy(grid[newStart.x][newStart.y][newStart.z]);
-            entropy += (newStart.y * 0.1);
-
-            frontier.push({entropy, newStart});
-            inFrontier.insert(newStart);
+            wave.Open(wave.Index(newStart.x, newStart.y, newStart.z),
+                      newStart.y * 0.1);
             newStartsAdded++;
           }
 
@@ -1632,11 +1649,10 @@ bool BlockGenerator::runSingleWFCAttempt(std::mt19937 &rng) {
     totalCellsProcessed++;
 
     // Try to collapse the cell
-    if (!collapseCellWFC(fc.pos.x, fc.pos.y, fc.pos.z, rng)) {
+    if (!collapseCellWFC(pos.x, pos.y, pos.z, rng)) {
 
       // Mark the cell as permanently failed (no possibilities)
-      cell.possibleBlockRotationPairs.clear();
-      inFrontier.erase(fc.pos);
+      wave.Clear(index);
       failedCells++;
 
       // If we have too many failed cells, this attempt is likely doomed
@@ -1648,9 +1664,13 @@ bool BlockGenerator::runSingleWFCAttempt(std::mt19937 &rng) {
         return false;
       }
 
+      // An empty cell next to an expecting socket undoes the last decisions
+      resolveContradiction();
+
       // Continue with next frontier cell - never abort on single failures
       continue;
     }
+    pushDecision(mark, index);
 
     // Successfully collapsed a cell
     cellsGenerated++;
@@ -1664,29 +1684,20 @@ bool BlockGenerator::runSingleWFCAttempt(std::mt19937 &rng) {
       break;
     }
 
-    inFrontier.erase(fc.pos);
-
     // Propagate constraints from this cell
-    propagateWave(fc.pos);
-
-    for (const auto &[dx, dy, dz] : neighborOffsets) {
-      int nx = fc.pos.x + dx, ny = fc.pos.y + dy, nz = fc.pos.z + dz;
-      GridPosition npos{nx, ny, nz};
+    propagateWave(pos);
+    if (resolveContradiction())
+      continue;
 
-      if (isValidGridPosition(nx, ny, nz) &&
-          !(parameters.generationSettings.isGridMaskEnabled &&
+    wave.ForEachNeighbor(index, [&](int, int neighbor) {
+      int nx, ny, nz;
+      wave.Position(neighbor, nx, ny, nz);
+      if (!(parameters.generationSettings.isGridMaskEnabled &&
             isGridCellMasked(nx, ny, nz)) &&
-          !grid[nx][ny][nz].collapsed &&
-          !grid[nx][ny][nz].possibleBlockRotationPairs.empty() &&
-          inFrontier.find(npos) == inFrontier.end()) {
-
-        double entropy = calculateCellEntropy(grid[nx][ny][nz]);
-        entropy += (ny * 0.1);
-
-        frontier.push({entropy, npos});
-        inFrontier.insert(npos);
-      }
-    }
+          !wave.IsCollapsed(neighbor) && !wave.IsEmpty(neighbor) &&
+          !wave.IsOpen(neighbor))
+        wave.Open(neighbor, ny * 0.1);
+    });
   }
 
   std::cout << "WFC attempt completed: " << totalCellsProcessed
@@ -1712,10 +1723,10 @@ bool BlockGenerator::isGenerationComplete() const {
           continue;
         }
 
-        const auto &cell = grid[x][y][z];
+        int index = wave.Index(x, y, z);
         // Consider a cell "complete" if it's either collapsed OR has no
         // possibilities (failed)
-        if (!cell.collapsed && !cell.possibleBlockRotationPairs.empty()) {
+        if (!wave.IsCollapsed(index) && !wave.IsEmpty(index)) {
           return false;
         }
       }
@@ -1734,9 +1745,9 @@ bool BlockGenerator::hasContradictions() const {
           continue;
         }
 
-        const auto &cell = grid[x][y][z];
+        int index = wave.Index(x, y, z);
         // Check for cells with no possibilities (contradiction)
-        if (!cell.collapsed && cell.possibleBlockRotationPairs.empty()) {
+        if (!wave.IsCollapsed(index) && wave.IsEmpty(index)) {
           return true;
         }
       }
@@ -1760,11 +1771,11 @@ void BlockGenerator::printGenerationSummary() const {
         }
 
         totalCells++;
-        const auto &cell = grid[x][y][z];
+        int index = wave.Index(x, y, z);
 
-        if (cell.collapsed) {
+        if (wave.IsCollapsed(index)) {
           collapsedCells++;
-        } else if (cell.possibleBlockRotationPairs.empty()) {
+        } else if (wave.IsEmpty(index)) {
           failedCells++;
         }
       }
@@ -1,4 +1,5 @@
 #include <GenWorld/Generators/TerrainGenerator.h>
+#include <GenWorld/Utils/Profiler.h>
 #include <GenWorld/Utils/perlin.h>
 #include <algorithm>
 #include <future>
@@ -24,6 +25,7 @@ void TerrainGenerator::Generate() {
 }
 
 std::vector<float> TerrainGenerator::GenerateHeightMap() {
+  Utils::Profiler::Scope scope("Height Map");
   std::vector<float> heightMap(parameters.numCellsWidth *
                                parameters.numCellsLength);
 
@@ -74,6 +76,7 @@ std::vector<float> TerrainGenerator::GenerateHeightMap() {
 
 Mesh *
 TerrainGenerator::GenerateFromHeightMap(const std::vector<float> &heightMap) {
+  Utils::Profiler::Scope scope("Terrain Mesh");
   std::vector<Vertex> vertices;
   std::vector<unsigned int> indices;
 
@@ -150,6 +153,7 @@ TerrainGenerator::GenerateFromHeightMap(const std::vector<float> &heightMap) {
 }
 
 void TerrainGenerator::GenerateDecorations() {
+  Utils::Profiler::Scope scope("Decorations");
   // This function spawns trees, rocks, etc.
   if (terrainMesh == nullptr) {
     return;
@@ -0,0 +1,116 @@
+#include <GenWorld/Generators/WFC/AdjacencyRules.h>
+#include <algorithm>
+#include <future>
+
+namespace WFC {
+void AdjacencyRules::Clear() {
+  variants.clear();
+  variantIndex.clear();
+  compatible.clear();
+  supporters.clear();
+  expects.clear();
+  words = 0;
+}
+
+int AdjacencyRules::AddVariant(int blockId, int rotation) {
+  auto it = variantIndex.find({blockId, rotation});
+  if (it != variantIndex.end())
+    return it->second;
+
+  int index = static_cast<int>(variants.size());
+  variants.push_back({blockId, rotation, {rotation}});
+  variantIndex[{blockId, rotation}] = index;
+  return index;
+}
+
+void AdjacencyRules::AddRotation(int variant, int rotation) {
+  Variant &target = variants[variant];
+  if (variantIndex.emplace(std::make_pair(target.blockId, rotation), variant)
+          .second)
+    target.rotations.push_back(rotation);
+}
+
+void AdjacencyRules::Finalize() {
+  words = WordsFor(VariantCount());
+  compatible.assign(static_cast<size_t>(VariantCount()) * kFaceCount * words,
+                    0);
+  supporters.assign(compatible.size(), 0);
+  expects.assign(static_cast<size_t>(VariantCount()) * kFaceCount, 0);
+}
+
+void AdjacencyRules::Allow(int variant, int face, int neighborVariant) {
+  SetBit(&compatible[(static_cast<size_t>(variant) * kFaceCount + face) *
+                     words],
+         neighborVariant);
+  SetBit(&supporters[(static_cast<size_t>(neighborVariant) * kFaceCount +
+                      OppositeFace(face)) *
+                     words],
+         variant);
+}
+
+void AdjacencyRules::AllowByFaceType(
+    const std::vector<uint8_t> &faceTypes, int typeCount,
+    const std::function<bool(int, int)> &connects) {
+  int variantCount = VariantCount();
+  auto typeOf = [&](int variant, int face) {
+    return faceTypes[static_cast<size_t>(variant) * kFaceCount + face];
+  };
+
+  // buckets[face][type]: variants whose socket on `face` has `type`
+  std::vector<uint64_t> buckets(
+      static_cast<size_t>(kFaceCount) * typeCount * words, 0);
+  auto bucket = [&](int face, int type) {
+    return &buckets[(static_cast<size_t>(face) * typeCount + type) * words];
+  };
+  for (int v = 0; v < variantCount; ++v)
+    for (int face = 0; face < kFaceCount; ++face)
+      SetBit(bucket(face, typeOf(v, face)), v);
+
+  // Only the connection table is consulted per type pair; both masks for a
+  // variant are then one copy of the mask for its socket type.
+  auto buildFace = [&](int face) {
+    int back = OppositeFace(face);
+    std::vector<uint64_t> accepted(static_cast<size_t>(typeCount) * words, 0);
+    std::vector<uint64_t> supporting(accepted.size(), 0);
+    for (int a = 0; a < typeCount; ++a) {
+      uint64_t *acceptedByA = &accepted[static_cast<size_t>(a) * words];
+      uint64_t *supportingA = &supporting[static_cast<size_t>(a) * words];
+      for (int b = 0; b < typeCount; ++b) {
+        // v across `face` of u: connects(type(v, back), type(u, face))
+        if (connects(b, a)) {
+          const uint64_t *variants = bucket(back, b);
+          for (int w = 0; w < words; ++w)
+            acceptedByA[w] |= variants[w];
+        }
+        // u across `face` of v supports v: connects(type(v, face), ...)
+        if (connects(a, b)) {
+          const uint64_t *variants = bucket(back, b);
+          for (int w = 0; w < words; ++w)
+            supportingA[w] |= variants[w];
+        }
+      }
+    }
+
+    for (int v = 0; v < variantCount; ++v) {
+      size_t offset = (static_cast<size_t>(v) * kFaceCount + face) * words;
+      size_t type = typeOf(v, face);
+      std::copy_n(&accepted[type * words], words, &compatible[offset]);
+      std::copy_n(&supporting[type * words], words, &supporters[offset]);
+      expects[static_cast<size_t>(v) * kFaceCount + face] =
+          AnyBit(&accepted[type * words], words);
+    }
+  };
+
+  // Each task writes only its own face's masks
+  std::vector<std::future<void>> tasks;
+  for (int face = 0; face < kFaceCount; ++face)
+    tasks.push_back(std::async(std::launch::async, buildFace, face));
+  for (auto &task : tasks)
+    task.get();
+}
+
+int AdjacencyRules::FindVariant(int blockId, int rotation) const {
+  auto it = variantIndex.find({blockId, rotation});
+  return it != variantIndex.end() ? it->second : -1;
+}
+} // namespace WFC
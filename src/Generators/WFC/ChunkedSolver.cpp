@@ -0,0 +1,254 @@
+#include <GenWorld/Generators/WFC/ChunkedSolver.h>
+#include <algorithm>
+#include <future>
+#include <thread>
+
+namespace WFC {
+void ChunkedSolver::Solve(const AdjacencyRules &rules,
+                          const std::vector<double> &weights, int width,
+                          int height, int length, const uint64_t *domain,
+                          const Options &options, const Acquire &acquire,
+                          const Release &release) {
+  this->rules = &rules;
+  this->weights = &weights;
+  this->domain = domain;
+  this->options = options;
+  this->acquire = acquire;
+  this->release = release;
+  this->width = width;
+  this->height = height;
+  this->length = length;
+  result.assign(static_cast<size_t>(width) * height * length, -1);
+
+  chunks.clear();
+  int size = std::max(1, options.chunkSize);
+  for (int cx = 0; cx * size < width; ++cx)
+    for (int cz = 0; cz * size < length; ++cz)
+      chunks.push_back({cx * size, cz * size, std::min((cx + 1) * size, width),
+                        std::min((cz + 1) * size, length), (cx + cz) & 1});
+
+  int threads = options.threads > 0
+                    ? options.threads
+                    : static_cast<int>(std::thread::hardware_concurrency());
+  threads = std::max(1, threads);
+
+  // A phase only reads cells written by the phase before it, and its own
+  // chunks write disjoint cells, so joining the workers is the only sync
+  std::atomic<int> left{0}, done{0};
+  for (int phase = 0; phase < 2; ++phase) {
+    std::vector<int> batch;
+    for (int i = 0; i < ChunkCount(); ++i)
+      if (chunks[i].phase == phase)
+        batch.push_back(i);
+
+    std::atomic<size_t> next{0};
+    auto worker = [&] {
+      Wave local;
+      size_t i;
+      while ((i = next++) < batch.size() &&
+             !(options.cancel && *options.cancel)) {
+        left += solveChunk(batch[i], local);
+        done++;
+      }
+    };
+    std::vector<std::future<void>> workers;
+    int count = std::min(threads, static_cast<int>(batch.size()));
+    for (int t = 0; t < count; ++t)
+      workers.push_back(std::async(std::launch::async, worker));
+    for (auto &task : workers)
+      task.get();
+  }
+  conflicts = left;
+  solved = done;
+}
+
+int ChunkedSolver::solveChunk(int chunkIndex, Wave &local) {
+  const Chunk &chunk = chunks[chunkIndex];
+  int width = chunk.x1 - chunk.x0, length = chunk.z1 - chunk.z0;
+  auto forEachInterior = [&](auto &&visit) {
+    for (int x = 0; x < width; ++x)
+      for (int y = 0; y < height; ++y)
+        for (int z = 0; z < length; ++z)
+          visit(local.Index(x + 1, y, z + 1),
+                ((chunk.x0 + x) * height + y) * this->length + chunk.z0 + z);
+  };
+
+  int left = 0;
+  for (int attempt = 0; attempt < std::max(1, options.attempts); ++attempt) {
+    // Claims from a discarded attempt go back before the next one
+    if (attempt > 0 && release)
+      forEachInterior([&](int cell, int) {
+        if (local.IsCollapsed(cell))
+          release(local.Chosen(cell));
+      });
+
+    std::seed_seq seeds{options.seed, static_cast<uint32_t>(chunkIndex),
+                        static_cast<uint32_t>(attempt)};
+    std::mt19937 rng(seeds);
+    left = solveAttempt(chunk, local, rng);
+    if (left == 0)
+      break;
+  }
+
+  forEachInterior(
+      [&](int cell, int global) { result[global] = local.Chosen(cell); });
+  return left;
+}
+
+int ChunkedSolver::solveAttempt(const Chunk &chunk, Wave &local,
+                                std::mt19937 &rng) {
+  int width = chunk.x1 - chunk.x0, length = chunk.z1 - chunk.z0;
+  local.SetJournaling(false);
+  local.Setup(rules, width + 2, height, length + 2);
+  local.SetWeights(*weights);
+
+  // Interior cells start from the full domain. A rim cell mirrors the solved
+  // neighbour it stands for, either its choice or an empty hole; rim
+  // corners, cells past the grid edge and the whole first-phase rim are
+  // blocked and constrain nothing.
+  auto interior = [&](int x, int z) {
+    return x > 0 && x <= width && z > 0 && z <= length;
+  };
+  std::vector<uint64_t> none(rules->WordCount(), 0);
+  std::vector<std::pair<int, int>> fixed;
+  for (int x = 0; x < width + 2; ++x) {
+    for (int y = 0; y < height; ++y) {
+      for (int z = 0; z < length + 2; ++z) {
+        int cell = local.Index(x, y, z);
+        if (interior(x, z)) {
+          local.SetDomain(cell, domain);
+          continue;
+        }
+        int gx = chunk.x0 + x - 1, gz = chunk.z0 + z - 1;
+        bool corner = (x == 0 || x == width + 1) && (z == 0 || z == length + 1);
+        if (corner || chunk.phase == 0 || gx < 0 || gx >= this->width ||
+            gz < 0 || gz >= this->length) {
+          local.Block(cell);
+          continue;
+        }
+        local.SetDomain(cell, none.data());
+        size_t global =
+            (static_cast<size_t>(gx) * height + y) * this->length + gz;
+        if (result[global] >= 0)
+          fixed.emplace_back(cell, result[global]);
+      }
+    }
+  }
+  for (const auto &[cell, variant] : fixed)
+    local.Assign(cell, variant);
+  // Dangling sockets between rim cells belong to the neighbouring chunks
+  local.ClearContradiction();
+
+  bool journaling = options.backtrackDepth > 0 && options.maxBacktracks > 0;
+  local.SetJournaling(journaling);
+
+  // Like the single-grid pass, growth starts from a few cells on the bottom
+  // layer and spreads to the neighbours of every placed block. Structures
+  // reaching in from the rim keep growing from where they cross over.
+  auto openNeighbors = [&](int cell) {
+    local.ForEachNeighbor(cell, [&](int, int neighbor) {
+      if (local.IsBlocked(neighbor) || local.IsCollapsed(neighbor) ||
+          local.IsEmpty(neighbor) || local.IsOpen(neighbor))
+        return;
+      int x, y, z;
+      local.Position(neighbor, x, y, z);
+      if (interior(x, z))
+        local.Open(neighbor, y * 0.1);
+    });
+  };
+  for (const auto &[cell, variant] : fixed)
+    openNeighbors(cell);
+  std::uniform_int_distribution<int> pickX(1, width), pickZ(1, length);
+  for (int i = 0; i < options.entryPoints; ++i) {
+    int cell = local.Index(pickX(rng), 0, pickZ(rng));
+    if (!local.IsEmpty(cell))
+      local.Open(cell, 0.0);
+  }
+
+  std::vector<std::pair<size_t, int>> decisions; // (journal mark, cell)
+  int backtracksLeft = options.maxBacktracks;
+  while (local.HasOpen()) {
+    size_t mark = local.JournalMark();
+    int cell = local.PopLowestEntropy();
+    if (local.IsCollapsed(cell) || local.IsEmpty(cell))
+      continue;
+
+    int variant = pickVariant(local, cell, rng);
+    if (variant >= 0) {
+      local.Assign(cell, variant);
+      openNeighbors(cell);
+      if (journaling) {
+        decisions.emplace_back(mark, cell);
+        if (static_cast<int>(decisions.size()) > options.backtrackDepth) {
+          decisions.erase(decisions.begin());
+          local.CommitJournal(decisions.front().first);
+        }
+      }
+    }
+
+    // Undo recent decisions until no socket dangles; past the limits the
+    // socket is kept and the chunk may be solved again
+    while (local.HasContradiction() && !decisions.empty() &&
+           backtracksLeft > 0) {
+      auto [decisionMark, decided] = decisions.back();
+      decisions.pop_back();
+      backtracksLeft--;
+      int undone = local.Chosen(decided);
+      local.Rollback(decisionMark, [&](int, int v) {
+        if (release)
+          release(v);
+      });
+      local.Ban(decided, undone);
+    }
+    local.ClearContradiction();
+  }
+
+  // Count sockets left open onto an unsolved cell. Pairs of rim cells were
+  // counted by the chunk they belong to.
+  int left = 0;
+  for (int x = 0; x < width + 2; ++x) {
+    for (int y = 0; y < height; ++y) {
+      for (int z = 0; z < length + 2; ++z) {
+        int cell = local.Index(x, y, z);
+        if (!local.IsCollapsed(cell))
+          continue;
+        local.ForEachNeighbor(cell, [&](int face, int neighbor) {
+          if (local.IsBlocked(neighbor) || local.IsCollapsed(neighbor) ||
+              !rules->ExpectsNeighbor(local.Chosen(cell), face))
+            return;
+          int nx, ny, nz;
+          local.Position(neighbor, nx, ny, nz);
+          if (interior(x, z) || interior(nx, nz))
+            left++;
+        });
+      }
+    }
+  }
+  return left;
+}
+
+int ChunkedSolver::pickVariant(Wave &local, int cell,
+                               std::mt19937 &rng) const {
+  int words = rules->WordCount();
+  while (!local.IsEmpty(cell)) {
+    double total = 0.0;
+    ForEachBit(local.Domain(cell), words,
+               [&](int v) { total += (*weights)[v]; });
+    double target = std::uniform_real_distribution<double>(0.0, total)(rng);
+
+    int picked = -1, last = -1;
+    ForEachBit(local.Domain(cell), words, [&](int v) {
+      last = v;
+      if (picked < 0 && (target -= (*weights)[v]) < 0.0)
+        picked = v;
+    });
+    if (picked < 0)
+      picked = last; // rounding, or every weight is zero
+
+    if (!acquire || acquire(picked))
+      return picked;
+    local.Ban(cell, picked);
+  }
+  return -1;
+}
+} // namespace WFC
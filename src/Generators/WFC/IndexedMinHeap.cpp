@@ -0,0 +1,83 @@
+#include <GenWorld/Generators/WFC/IndexedMinHeap.h>
+
+namespace WFC {
+void IndexedMinHeap::Reset(int capacity) {
+  heap.clear();
+  positions.assign(capacity, -1);
+}
+
+void IndexedMinHeap::Push(int item, double key) {
+  int slot = positions[item];
+  if (slot < 0) {
+    heap.push_back({key, item});
+    positions[item] = static_cast<int>(heap.size() - 1);
+    siftUp(heap.size() - 1);
+    return;
+  }
+
+  double old = heap[slot].key;
+  heap[slot].key = key;
+  if (key < old)
+    siftUp(slot);
+  else
+    siftDown(slot);
+}
+
+void IndexedMinHeap::Remove(int item) {
+  int slot = positions[item];
+  if (slot < 0)
+    return;
+  positions[item] = -1;
+
+  Entry last = heap.back();
+  heap.pop_back();
+  if (static_cast<size_t>(slot) == heap.size())
+    return;
+
+  place(slot, last);
+  siftUp(slot);
+  siftDown(positions[last.item]);
+}
+
+int IndexedMinHeap::Pop() {
+  if (heap.empty())
+    return -1;
+  int item = heap.front().item;
+  Remove(item);
+  return item;
+}
+
+void IndexedMinHeap::place(size_t slot, const Entry &entry) {
+  heap[slot] = entry;
+  positions[entry.item] = static_cast<int>(slot);
+}
+
+void IndexedMinHeap::siftUp(size_t slot) {
+  Entry entry = heap[slot];
+  while (slot > 0) {
+    size_t parent = (slot - 1) / 2;
+    if (!before(entry, heap[parent]))
+      break;
+    place(slot, heap[parent]);
+    slot = parent;
+  }
+  place(slot, entry);
+}
+
+void IndexedMinHeap::siftDown(size_t slot) {
+  Entry entry = heap[slot];
+  size_t count = heap.size();
+  while (true) {
+    size_t child = slot * 2 + 1;
+    if (child >= count)
+      break;
+    if (child + 1 < count && before(heap[child + 1], heap[child]))
+      ++child;
+    if (!before(heap[child], entry))
+      break;
+    place(slot, heap[child]);
+    slot = child;
+  }
+  place(slot, entry);
+}
+} // namespace WFC
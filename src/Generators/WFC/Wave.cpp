@@ -0,0 +1,433 @@
+#include <GenWorld/Generators/WFC/Wave.h>
+#include <algorithm>
+#include <cmath>
+
+namespace WFC {
+void Wave::Setup(const AdjacencyRules *rules, int width, int height,
+                 int length) {
+  this->rules = rules;
+  shape = {width, height, length};
+  words = rules->WordCount();
+  if (shape.IsFlat()) {
+    isSupportedOn = &Wave::isSupported<FlatLattice>;
+    propagateOnShape = &Wave::propagateOn<FlatLattice>;
+  } else {
+    isSupportedOn = &Wave::isSupported<VolumeLattice>;
+    propagateOnShape = &Wave::propagateOn<VolumeLattice>;
+  }
+
+  domains.assign(static_cast<size_t>(CellCount()) * words, 0);
+  blocked.assign(CellCount(), 0);
+  chosen.assign(CellCount(), -1);
+  // Counts are only read once built by recount(), so they need no clearing
+  support.resize(static_cast<size_t>(CellCount()) * rules->VariantCount() *
+                 kFaceCount);
+
+  // Weights carry over between runs with the same rule set
+  if (static_cast<int>(weights.size()) != rules->VariantCount()) {
+    weights.assign(rules->VariantCount(), 1.0);
+    weightLogWeights.assign(rules->VariantCount(), 0.0);
+  }
+  sumWeights.assign(CellCount(), 0.0);
+  sumWeightLogWeights.assign(CellCount(), 0.0);
+  sumEpoch.assign(CellCount(), 0);
+  weightEpoch = 1;
+  frontierBias.assign(CellCount(), 0.0);
+  frontier.Reset(CellCount());
+
+  removals.clear();
+  dirtyQueue.clear();
+  dirtyHead = 0;
+  inDirtyQueue.assign(CellCount(), 0);
+  rolledBack.clear();
+  inRolledBack.assign(CellCount(), 0);
+  cellScratch.reserve(CellCount());
+  reopened.reserve(CellCount());
+  contradiction = false;
+  journal.clear();
+  journalBase = 0;
+}
+
+int Wave::Neighbor(int cell, int face) const {
+  switch (face) {
+  case 0:
+    return shape.Neighbor<0>(cell);
+  case 1:
+    return shape.Neighbor<1>(cell);
+  case 2:
+    return shape.Neighbor<2>(cell);
+  case 3:
+    return shape.Neighbor<3>(cell);
+  case 4:
+    return shape.Neighbor<4>(cell);
+  case 5:
+    return shape.Neighbor<5>(cell);
+  default:
+    return -1;
+  }
+}
+
+void Wave::SetDomain(int cell, const uint64_t *mask) {
+  std::copy(mask, mask + words, &domains[static_cast<size_t>(cell) * words]);
+  chosen[cell] = -1;
+  sumEpoch[cell] = 0; // summed on first use
+  recountAround(cell);
+}
+
+void Wave::Ban(int cell, int variant) {
+  if (!IsAllowed(cell, variant))
+    return;
+  remove(cell, variant);
+  propagate();
+}
+
+void Wave::BanOpen(const uint64_t *mask) {
+  // Re-keying moves heap entries, so the cells are listed first
+  listOpen();
+
+  // Open cells are uncollapsed, so their hole support still covers every
+  // neighbour and nothing has to propagate; each cell is re-keyed once
+  // rather than once per variant
+  for (int cell : cellScratch) {
+    uint64_t *domain = &domains[static_cast<size_t>(cell) * words];
+    bool hit = false;
+    for (int w = 0; w < words; ++w) {
+      uint64_t banned = domain[w] & mask[w];
+      if (!banned)
+        continue;
+      hit = true;
+      domain[w] &= ~banned;
+      ForEachBit(&banned, 1, [&](int bit) {
+        int variant = (w << 6) + bit;
+        if (sumEpoch[cell] == weightEpoch) {
+          sumWeights[cell] -= weights[variant];
+          sumWeightLogWeights[cell] -= weightLogWeights[variant];
+        }
+        record(kRemoved, cell, variant);
+      });
+    }
+    if (!hit)
+      continue;
+    frontier.Push(cell, Entropy(cell) + frontierBias[cell]);
+    markDirty(cell);
+    if (IsEmpty(cell))
+      checkExpected(cell);
+  }
+}
+
+void Wave::Clear(int cell) {
+  ForEachBit(Domain(cell), words, [&](int v) { remove(cell, v); });
+  propagate();
+}
+
+void Wave::Assign(int cell, int variant) {
+  ForEachBit(Domain(cell), words, [&](int v) {
+    if (v != variant)
+      remove(cell, v);
+  });
+
+  // Forced placements may assign a variant that was already removed
+  bool added = !IsAllowed(cell, variant);
+  if (added) {
+    SetBit(&domains[static_cast<size_t>(cell) * words], variant);
+    record(kAdded, cell, variant);
+  }
+
+  // Collapsing drops the cell's hole support and a forced variant adds
+  // support no count holds yet; either way the neighbours' counts toward
+  // the cell are rebuilt from its domain. That covers the removals above,
+  // which are all the queue holds, as mutators propagate before returning.
+  if (chosen[cell] < 0 || added) {
+    removals.clear();
+    removals.emplace_back(cell, kHole);
+  }
+  record(kCollapsed, cell, chosen[cell]);
+  chosen[cell] = variant;
+  if (frontier.Contains(cell)) {
+    record(kClosed, cell, 0, frontierBias[cell]);
+    frontier.Remove(cell);
+  }
+  propagate();
+
+  // Neighbours that were already empty now leave one of its sockets open
+  ForEachNeighbor(cell, [&](int face, int neighbor) {
+    if (tracks(neighbor) && IsEmpty(neighbor) &&
+        rules->ExpectsNeighbor(variant, face))
+      contradiction = true;
+  });
+}
+
+void Wave::Settle(int cell, int variant) {
+  uint64_t *domain = &domains[static_cast<size_t>(cell) * words];
+  std::fill(domain, domain + words, 0);
+  if (variant >= 0)
+    SetBit(domain, variant);
+  chosen[cell] = variant;
+  sumEpoch[cell] = 0;
+  frontier.Remove(cell);
+  recountAround(cell);
+}
+
+int Wave::SingleVariant(int cell) const {
+  const uint64_t *domain = Domain(cell);
+  int found = -1;
+  for (int w = 0; w < words; ++w) {
+    if (!domain[w])
+      continue;
+    if (found != -1 || (domain[w] & (domain[w] - 1)))
+      return -1;
+    found = (w << 6) + CountTrailingZeros(domain[w]);
+  }
+  return found;
+}
+
+template <typename L>
+bool Wave::isSupported(int cell, int variant) const {
+  return L::AllFaces([&](auto face) {
+    constexpr int kFace = decltype(face)::value;
+    int neighbor = shape.Neighbor<kFace>(cell);
+    return neighbor < 0 || supportedBy(neighbor, variant, kFace);
+  });
+}
+
+int Wave::PopDirty() {
+  if (dirtyHead == dirtyQueue.size()) {
+    dirtyQueue.clear();
+    dirtyHead = 0;
+    return -1;
+  }
+  int cell = dirtyQueue[dirtyHead++];
+  inDirtyQueue[cell] = 0;
+  return cell;
+}
+
+void Wave::SetWeights(const std::vector<double> &weights) {
+  if (weights == this->weights)
+    return;
+  this->weights = weights;
+  weightLogWeights.resize(weights.size());
+  for (size_t v = 0; v < weights.size(); ++v)
+    weightLogWeights[v] =
+        weights[v] > 0.0 ? weights[v] * std::log(weights[v]) : 0.0;
+
+  // Every cell's sums go stale; only the open cells are re-summed now, the
+  // rest when they are next opened
+  ++weightEpoch;
+  listOpen();
+  for (int cell : cellScratch)
+    frontier.Push(cell, Entropy(cell) + frontierBias[cell]);
+}
+
+double Wave::Entropy(int cell) const {
+  if (chosen[cell] >= 0 || IsEmpty(cell))
+    return 0.0;
+  if (sumEpoch[cell] != weightEpoch)
+    resum(cell);
+  double sum = sumWeights[cell];
+  if (sum <= 0.0)
+    return 0.0;
+  return std::log(sum) - sumWeightLogWeights[cell] / sum;
+}
+
+void Wave::Open(int cell, double bias) {
+  record(kOpened, cell, frontier.Contains(cell), frontierBias[cell]);
+  frontierBias[cell] = bias;
+  frontier.Push(cell, Entropy(cell) + bias);
+}
+
+int Wave::PopLowestEntropy() {
+  if (frontier.Empty())
+    return -1;
+  record(kClosed, frontier.Top(), 0, frontierBias[frontier.Top()]);
+  return frontier.Pop();
+}
+
+void Wave::SetJournaling(bool enabled) {
+  journaling = enabled;
+  if (!enabled)
+    CommitJournal(JournalMark());
+}
+
+void Wave::Rollback(size_t mark,
+                    const std::function<void(int, int)> &onUncollapse) {
+  // Frontier keys depend on the restored domains and choices, so cells are
+  // only re-keyed once everything else is back
+  reopened.clear();
+  while (JournalMark() > mark && !journal.empty()) {
+    JournalEntry entry = journal.back();
+    journal.pop_back();
+    int cell = entry.cell;
+    if (!inRolledBack[cell]) {
+      inRolledBack[cell] = 1;
+      rolledBack.push_back(cell);
+    }
+    switch (entry.kind) {
+    case kRemoved:
+      SetBit(&domains[static_cast<size_t>(cell) * words], entry.value);
+      sumEpoch[cell] = 0;
+      break;
+    case kAdded:
+      ClearBit(&domains[static_cast<size_t>(cell) * words], entry.value);
+      sumEpoch[cell] = 0;
+      break;
+    case kCollapsed: {
+      int variant = chosen[cell];
+      chosen[cell] = entry.value;
+      if (onUncollapse)
+        onUncollapse(cell, variant);
+      break;
+    }
+    case kOpened:
+      if (!entry.value)
+        frontier.Remove(cell);
+      frontierBias[cell] = entry.bias;
+      reopened.push_back(cell);
+      break;
+    case kClosed:
+      frontierBias[cell] = entry.bias;
+      frontier.Push(cell, 0.0);
+      reopened.push_back(cell);
+      break;
+    }
+  }
+  for (int cell : reopened)
+    if (frontier.Contains(cell))
+      frontier.Push(cell, Entropy(cell) + frontierBias[cell]);
+  // Counts are not journaled; the restored state was consistent, so they
+  // are rebuilt from it
+  for (int cell : rolledBack) {
+    inRolledBack[cell] = 0;
+    recountAround(cell);
+  }
+  rolledBack.clear();
+
+  removals.clear();
+  for (size_t i = dirtyHead; i < dirtyQueue.size(); ++i)
+    inDirtyQueue[dirtyQueue[i]] = 0;
+  dirtyQueue.clear();
+  dirtyHead = 0;
+  contradiction = false;
+}
+
+void Wave::CommitJournal(size_t mark) {
+  while (journalBase < mark && !journal.empty()) {
+    journal.pop_front();
+    ++journalBase;
+  }
+}
+
+void Wave::resum(int cell) const {
+  double sum = 0.0, logSum = 0.0;
+  ForEachBit(Domain(cell), words, [&](int v) {
+    sum += weights[v];
+    logSum += weightLogWeights[v];
+  });
+  sumWeights[cell] = sum;
+  sumWeightLogWeights[cell] = logSum;
+  sumEpoch[cell] = weightEpoch;
+}
+
+bool Wave::supportedBy(int holder, int variant, int face) const {
+  // Masked cells and possible holes support everything
+  if (blocked[holder] || chosen[holder] < 0)
+    return true;
+
+  const uint64_t *domain = Domain(holder);
+  const uint64_t *supporters = rules->Supporters(variant, face);
+  for (int w = 0; w < words; ++w)
+    if (domain[w] & supporters[w])
+      return true;
+  return false;
+}
+
+void Wave::remove(int cell, int variant) {
+  ClearBit(&domains[static_cast<size_t>(cell) * words], variant);
+  if (sumEpoch[cell] == weightEpoch) {
+    sumWeights[cell] -= weights[variant];
+    sumWeightLogWeights[cell] -= weightLogWeights[variant];
+  }
+  if (frontier.Contains(cell))
+    frontier.Push(cell, Entropy(cell) + frontierBias[cell]);
+  // Until the cell collapses its hole support covers every neighbour
+  if (counted(cell))
+    removals.emplace_back(cell, variant);
+  record(kRemoved, cell, variant);
+  markDirty(cell);
+  if (chosen[cell] < 0 && IsEmpty(cell))
+    checkExpected(cell);
+}
+
+void Wave::checkExpected(int cell) {
+  ForEachNeighbor(cell, [&](int face, int neighbor) {
+    if (chosen[neighbor] >= 0 &&
+        rules->ExpectsNeighbor(chosen[neighbor], OppositeFace(face)))
+      contradiction = true;
+  });
+}
+
+void Wave::listOpen() {
+  cellScratch.clear();
+  for (int slot = 0; slot < frontier.Size(); ++slot)
+    cellScratch.push_back(frontier.ItemAt(slot));
+}
+
+void Wave::markDirty(int cell) {
+  if (inDirtyQueue[cell])
+    return;
+  inDirtyQueue[cell] = 1;
+  dirtyQueue.push_back(cell);
+}
+
+void Wave::recount(int cell, int face, int holder, bool ban) {
+  const uint64_t *held = Domain(holder);
+  ForEachBit(Domain(cell), words, [&](int v) {
+    const uint64_t *supporters = rules->Supporters(v, face);
+    int count = 0;
+    for (int w = 0; w < words; ++w)
+      count += PopCount(held[w] & supporters[w]);
+    supportOf(cell, v)[face] = static_cast<uint8_t>(std::min(count, 255));
+    if (ban && count == 0)
+      remove(cell, v);
+  });
+}
+
+void Wave::recountAround(int cell) {
+  ForEachNeighbor(cell, [&](int face, int neighbor) {
+    if (tracks(cell) && counted(neighbor))
+      recount(cell, face, neighbor, false);
+    else if (counted(cell) && tracks(neighbor))
+      recount(neighbor, OppositeFace(face), cell, false);
+  });
+}
+
+template <typename L> void Wave::propagateOn() {
+  while (!removals.empty()) {
+    auto [cell, removed] = removals.back();
+    removals.pop_back();
+
+    shape.ForEachNeighbor<L>(cell, [&](int face, int neighbor) {
+      if (!tracks(neighbor))
+        return;
+
+      // The support a neighbour gets across `back` is this cell's
+      int back = OppositeFace(face);
+      if (removed == kHole) {
+        recount(neighbor, back, cell, true);
+        return;
+      }
+      // Only the neighbour variants the removed one allowed lose a count
+      const uint64_t *allowed = rules->Compatible(removed, face);
+      const uint64_t *domain = Domain(neighbor);
+      for (int w = 0; w < words; ++w) {
+        uint64_t lost = allowed[w] & domain[w];
+        ForEachBit(&lost, 1, [&](int bit) {
+          int v = (w << 6) + bit;
+          uint8_t &count = supportOf(neighbor, v)[back];
+          if (count > 0 && --count == 0)
+            remove(neighbor, v);
+        });
+      }
+    });
+  }
+}
+} // namespace WFC
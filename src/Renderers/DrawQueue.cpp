@@ -0,0 +1,32 @@
+#include <GenWorld/Drawables/Mesh.h>
+#include <GenWorld/Renderers/DrawQueue.h>
+#include <algorithm>
+#include <tuple>
+
+DrawQueue *DrawQueue::active = nullptr;
+
+void DrawQueue::Begin() {
+  items.clear();
+  active = this;
+}
+
+void DrawQueue::Push(const Item &item) { items.push_back(item); }
+
+void DrawQueue::Flush() {
+  // Stable, so draws sharing all their state keep the order they came in
+  std::stable_sort(items.begin(), items.end(),
+                   [](const Item &a, const Item &b) {
+                     return std::tie(a.program, a.textures, a.vertexArray) <
+                            std::tie(b.program, b.textures, b.vertexArray);
+                   });
+
+  for (const Item &item : items)
+    item.mesh->Submit(item.instanceCount);
+  items.clear();
+}
+
+void DrawQueue::End() {
+  Flush();
+  if (active == this)
+    active = nullptr;
+}
@@ -1,4 +1,7 @@
 #include <GenWorld/Renderers/Renderer.h>
+#include <GenWorld/Core/GLState.h>
+#include <GenWorld/Utils/Profiler.h>
+#include <cstring>
 
 Renderer::~Renderer() {
   // Cleanup if necessary
@@ -24,19 +27,78 @@ void Renderer::SetScreenSize(float width, float height) {
 
 glm::vec2 Renderer::GetScreenSize() { return screenSize; }
 
+void Renderer::MarkDirty() { dirty = true; }
+
+// The camera and the set of drawables are compared against the last frame
+// here; changes inside a drawable, which the renderer cannot see, are
+// reported through MarkDirty().
+bool Renderer::NeedsRender() const {
+  if (dirty || renderQueue != renderedQueue)
+    return true;
+  if (currentCamera == nullptr)
+    return false;
+  return currentCamera->GetViewMatrix() != renderedView ||
+         currentCamera->GetProjectionMatrix(
+             (float)screenSize.x / (float)screenSize.y) != renderedProjection;
+}
+
 void Renderer::renderScene() {
   if (currentCamera == nullptr)
     return;
+  Utils::Profiler::Scope scope("Render Scene");
+  Utils::Profiler::GpuScope gpuScope("Scene");
 
   glm::mat4 view = currentCamera->GetViewMatrix();
-  glm::mat4 projection = glm::perspective(
-      glm::radians(currentCamera->zoom),
-      (float)screenSize.x / (float)screenSize.y, 0.1f, 1000.0f);
+  glm::mat4 projection = currentCamera->GetProjectionMatrix(
+      (float)screenSize.x / (float)screenSize.y);
+  renderedView = view;
+  renderedProjection = projection;
+  renderedQueue = renderQueue;
+  dirty = false;
+  // ImGui and resource loading bind behind the state cache's back
+  GLState::Invalidate();
+  updateFrameUniforms(view, projection);
 
+  // Meshes queue their draws while the scene is walked; they are issued
+  // together, sorted by shader, textures and vertex array
+  drawQueue.Begin();
   for (IDrawable *mesh : renderQueue) {
     if (mesh != nullptr) {
       mesh->SetShaderParameters(currentShadingParams);
       mesh->Draw(view, projection);
     }
   }
+  drawQueue.End();
+}
+
+void Renderer::updateFrameUniforms(const glm::mat4 &view,
+                                   const glm::mat4 &projection) {
+  // Created on first use, once the GL context is current
+  if (!cameraUniforms) {
+    cameraUniforms = std::make_unique<UniformBuffer>(
+        FrameUniforms::kCameraBinding, sizeof(FrameUniforms::Camera));
+    shadingUniforms = std::make_unique<UniformBuffer>(
+        FrameUniforms::kShadingBinding, sizeof(FrameUniforms::Shading));
+  }
+
+  FrameUniforms::Camera camera{view, projection};
+  cameraUniforms->Update(&camera, sizeof(camera));
+
+  const ShadingParameters &params = currentShadingParams;
+  FrameUniforms::Shading shading{};
+  shading.lightDirection = params.lightDirection;
+  shading.lightAmbient = params.lightColor * params.ambient;
+  shading.lightDiffuse = params.lightColor * params.diffuse;
+  shading.wireframeColor = params.wireframeColor;
+  shading.wireframeWidth = params.wireframeWidth;
+  shading.fillColor = params.filledWireframeColor;
+  shading.solidColor = params.solidColor;
+
+  // Shading only changes when the panel is edited
+  if (!shadingUploaded ||
+      std::memcmp(&shading, &uploadedShading, sizeof(shading)) != 0) {
+    shadingUniforms->Update(&shading, sizeof(shading));
+    uploadedShading = shading;
+    shadingUploaded = true;
+  }
 }
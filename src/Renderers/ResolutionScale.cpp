@@ -0,0 +1,30 @@
+#include <GenWorld/Renderers/ResolutionScale.h>
+#include <algorithm>
+#include <cmath>
+
+bool ResolutionScale::Update(bool hasSample, float milliseconds,
+                             bool interacting) {
+  float previous = scale;
+  if (!interacting) {
+    scale = 1.0f;
+    return scale != previous;
+  }
+  // Inside the band around the budget the scale is left alone, so it does
+  // not swing back and forth between two steps
+  if (!hasSample || milliseconds <= 0.0f ||
+      (milliseconds <= 1.1f * kBudgetMilliseconds &&
+       milliseconds >= 0.8f * kBudgetMilliseconds))
+    return false;
+  bool over = milliseconds > kBudgetMilliseconds;
+
+  // The cost of a frame goes roughly with its pixel count, the square of
+  // the scale. Samples lag the scale by a frame or two, so each one only
+  // moves half way to the scale it asks for.
+  float ideal = scale * std::sqrt(kBudgetMilliseconds / milliseconds);
+  ideal = std::clamp(ideal, kMinScale, 1.0f);
+  // At least one step is taken, however small the request
+  float next = std::round((scale + 0.5f * (ideal - scale)) / kStep) * kStep;
+  next = over ? std::min(next, scale - kStep) : std::max(next, scale + kStep);
+  scale = std::clamp(next, kMinScale, 1.0f);
+  return scale != previous;
+}
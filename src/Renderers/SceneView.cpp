@@ -7,6 +7,7 @@ bool SceneView::init(AppWindow *wind) {
   m_ShadingPanel.setOnParametersChanged(
       [this](const ShadingParameters &params) {
         renderer->updateShadingParameters(params);
+        renderer->MarkDirty();
       });
   return true;
 }
@@ -30,13 +31,38 @@ void SceneView::renderSceneView() {
 
   m_ViewportSize = {viewportSize.x, viewportSize.y};
   renderer->SetScreenSize(m_ViewportSize);
-  framebuffer.Resize(m_ViewportSize.x, m_ViewportSize.y);
-  window->setViewPortSize(framebuffer.GetWidth(), framebuffer.GetHeight());
 
-  framebuffer.bind();
-  window->clearBuffers();
-  renderer->Render();
-  framebuffer.unbind();
+  // Heavy scenes render smaller while the camera moves or a panel is being
+  // dragged, and at full size again as soon as that stops
+  bool editing = ImGui::IsAnyItemActive();
+  bool interacting = editing || (camMode && renderer->NeedsRender());
+  float sceneMilliseconds = 0.0f;
+  bool hasSample = sceneTimer.Poll(sceneMilliseconds);
+  resolutionScale.Update(hasSample, sceneMilliseconds, interacting);
+  float scale = resolutionScale.Get();
+
+  // Resizing replaces the framebuffer's texture, so the old frame is gone
+  int previousWidth = framebuffer.GetWidth();
+  int previousHeight = framebuffer.GetHeight();
+  framebuffer.Resize(m_ViewportSize.x * scale, m_ViewportSize.y * scale);
+  if (framebuffer.GetWidth() != previousWidth ||
+      framebuffer.GetHeight() != previousHeight)
+    renderer->MarkDirty();
+  // Generator panels edit their drawables in place while a widget is held
+  if (editing)
+    renderer->MarkDirty();
+
+  // Otherwise the last frame is still in the framebuffer and is shown again
+  sceneRendered = renderer->NeedsRender();
+  if (sceneRendered) {
+    window->setViewPortSize(framebuffer.GetWidth(), framebuffer.GetHeight());
+    framebuffer.bind();
+    window->clearBuffers();
+    sceneTimer.Begin();
+    renderer->Render();
+    sceneTimer.End();
+    framebuffer.unbind();
+  }
 
   // add rendered texture to ImGUI scene window
   uint64_t textureID = framebuffer.GetColorTextureID();
@@ -48,6 +74,8 @@ void SceneView::renderSceneView() {
   ImGui::End();
 }
 
+bool SceneView::IsIdle() const { return !sceneRendered && !camMode; }
+
 void SceneView::renderViewportShading() { m_ShadingPanel.render(); }
 
 void SceneView::renderGlobalButtons() { m_GlobalButtons.render(); }
@@ -1,5 +1,6 @@
 #include <GenWorld/Renderers/UiContext.h>
 #include <GenWorld/Utils/ImGuizmo.h>
+#include <GenWorld/Utils/Profiler.h>
 #include <cstring>
 #include <glm/gtc/type_ptr.hpp>
 
@@ -78,9 +79,14 @@ void UiContext::render() {
 
   // Render the scene overlay
   renderSceneOverlay();
+
+  if (showProfiler)
+    Utils::Profiler::DrawWindow(&showProfiler);
 }
 
 void UiContext::postRender() {
+  Utils::Profiler::Scope scope("ImGui Render");
+  Utils::Profiler::GpuScope gpuScope("ImGui");
   // ImGui Rendering
   ImGui::Render();
   ImGui_ImplOpenGL3_RenderDrawData(ImGui::GetDrawData());
@@ -137,6 +143,13 @@ void UiContext::renderMenuBar() {
         if (ImGui::MenuItem("OBJ", "(.obj + .mtl)")) {
           exportMesh("obj");
         }
+        if (ImGui::MenuItem("Profiler Trace", "(.json)")) {
+          std::string file = Utils::FileDialogs::SaveFile(
+              "Export Profiler Trace", "Chrome Trace\0*.json\0",
+              window->getNativeWindow());
+          if (!file.empty() && !Utils::Profiler::ExportTrace(file))
+            std::cerr << "Failed to write trace " << file << std::endl;
+        }
         ImGui::EndMenu();
       }
       ImGui::Separator();
@@ -158,6 +171,7 @@ void UiContext::renderMenuBar() {
         }
         ImGui::EndMenu();
       }
+      ImGui::MenuItem("Profiler", nullptr, &showProfiler);
       ImGui::EndMenu();
     }
 
@@ -1,4 +1,6 @@
 #include <GenWorld/SocketSystem/SocketSystem.h>
+#include <algorithm>
+#include <array>
 #include <iostream>
 
 void SocketSystem::Initialize() {}
@@ -82,44 +84,105 @@ SocketSystem::RotateSockets(const std::array<Socket, 6> &original,
   return rotated;
 }
 
-std::array<Socket, 6> SocketSystem::GetRotatedSockets(int blockId,
-                                                      int rotation) const {
+const std::array<Socket, 6> *
+SocketSystem::findRotatedSockets(int blockId, int rotation) const {
   auto it = rotatedVariants.find(blockId);
-  if (it == rotatedVariants.end()) {
-    std::cerr << "No variants found for block " << blockId << std::endl;
-    return {};
-  }
+  if (it == rotatedVariants.end())
+    return nullptr;
 
   for (const auto &variant : it->second) {
     if (variant.rotationY == rotation) {
-      return variant.rotatedSockets;
+      return &variant.rotatedSockets;
     }
   }
+  return nullptr;
+}
 
-  std::cerr << "No variant found for block " << blockId << " with rotation "
-            << rotation << std::endl;
-  return {};
+std::array<Socket, 6> SocketSystem::GetRotatedSockets(int blockId,
+                                                      int rotation) const {
+  if (rotatedVariants.find(blockId) == rotatedVariants.end()) {
+    std::cerr << "No variants found for block " << blockId << std::endl;
+    return {};
+  }
+
+  const auto *sockets = findRotatedSockets(blockId, rotation);
+  if (!sockets) {
+    std::cerr << "No variant found for block " << blockId
+              << " with rotation " << rotation << std::endl;
+    return {};
+  }
+  return *sockets;
 }
 
 bool SocketSystem::CanBlocksConnect(int blockId1, int rotation1, int face1,
                                     int blockId2, int rotation2, int face2,
                                     bool neighborIsEmpty) const {
-  auto sockets1 = GetRotatedSockets(blockId1, rotation1);
-
-  SocketType type2;
-  if (neighborIsEmpty) {
-    type2 = SocketType::EMPTY; // Treat as wildcard
-  } else {
-    auto sockets2 = GetRotatedSockets(blockId2, rotation2);
-    type2 = sockets2[face2].type;
-  }
-
-  SocketType type1 = sockets1[face1].type;
-
   // If neighbor is empty, allow any connection
   if (neighborIsEmpty) {
     return true;
   }
 
+  // Missing variants read as all-EMPTY sockets, as GetRotatedSockets does
+  const auto *sockets1 = findRotatedSockets(blockId1, rotation1);
+  const auto *sockets2 = findRotatedSockets(blockId2, rotation2);
+  SocketType type1 = sockets1 ? (*sockets1)[face1].type : SocketType::EMPTY;
+  SocketType type2 = sockets2 ? (*sockets2)[face2].type : SocketType::EMPTY;
+
   return compatibility.CanConnect(type1, type2);
 }
+
+CompiledSockets SocketSystem::Compile() const {
+  CompiledSockets compiled;
+
+  // Variants follow template order, then allowedRotations order, matching
+  // GenerateRotatedVariants(). A rotation whose socket types match an
+  // earlier variant of the same block joins that variant's rotation set.
+  int maxType = 0;
+  for (const auto &[blockId, blockTemplate] : blockTemplates) {
+    int firstVariant = compiled.VariantCount();
+    for (int rotation : blockTemplate.allowedRotations) {
+      auto sockets = RotateSockets(blockTemplate.sockets, rotation);
+      std::array<uint8_t, 6> types;
+      for (size_t face = 0; face < sockets.size(); ++face)
+        types[face] = static_cast<uint8_t>(sockets[face].type);
+
+      int match = -1;
+      for (int v = firstVariant; v < compiled.VariantCount() && match < 0;
+           ++v)
+        if (std::equal(types.begin(), types.end(),
+                       compiled.faceTypes.begin() + v * 6))
+          match = v;
+      if (match >= 0) {
+        auto &rotationSet = compiled.rotationSets[match];
+        if (std::find(rotationSet.begin(), rotationSet.end(), rotation) ==
+            rotationSet.end())
+          rotationSet.push_back(rotation);
+        continue;
+      }
+
+      compiled.blockIds.push_back(blockId);
+      compiled.rotations.push_back(rotation);
+      compiled.rotationSets.push_back({rotation});
+      compiled.faceTypes.insert(compiled.faceTypes.end(), types.begin(),
+                                types.end());
+      for (uint8_t type : types)
+        maxType = std::max(maxType, static_cast<int>(type));
+    }
+  }
+
+  // Rules may mention socket types no template uses, so cover the whole enum
+  compiled.typeCount = std::max(maxType + 1,
+                                static_cast<int>(SocketType::CUSTOM_5) + 1);
+  compiled.typeWords = (compiled.typeCount + 63) / 64;
+  compiled.connects.assign(
+      static_cast<size_t>(compiled.typeCount) * compiled.typeWords, 0);
+  for (int from = 0; from < compiled.typeCount; ++from) {
+    for (int to = 0; to < compiled.typeCount; ++to) {
+      if (compatibility.CanConnect(static_cast<SocketType>(from),
+                                   static_cast<SocketType>(to)))
+        compiled.connects[static_cast<size_t>(from) * compiled.typeWords +
+                          (to >> 6)] |= uint64_t(1) << (to & 63);
+    }
+  }
+  return compiled;
+}
@@ -7,6 +7,7 @@
 #include <GenWorld/UI/BlockUI.h>
 #define IMGUI_DEFINE_MATH_OPERATORS
 #include <GenWorld/Core/BlockData.h>
+#include <GenWorld/Drawables/IndirectBatch.h>
 #include <algorithm>
 #include <cctype>
 #include <cstring>
@@ -124,6 +125,23 @@ void BlockUI::DisplayBasicSettings() {
     if (ImGui::Button("Reset Grid Scale")) {
       parameters.gridScale = 1.0f;
     }
+
+    ImGui::Separator();
+
+    // Blocks sealed by solid faces on all six sides are not drawn
+    auto &settings = parameters.generationSettings;
+    ImGui::Checkbox("Cull Interior Blocks", &settings.cullInteriorBlocks);
+    if (settings.cullInteriorBlocks)
+      ImGui::Checkbox("Export Interior Blocks", &settings.exportInteriorBlocks);
+    // Merges blocks into static buffers per material; for finished builds
+    ImGui::Checkbox("Bake Static Batches", &settings.bakeStaticBatches);
+    if (settings.bakeStaticBatches)
+      ImGui::DragInt("Batch Vertex Limit", &settings.staticBatchVertices,
+                     1024.0f, 1024, 1 << 24);
+    // One multi-draw per material instead of one draw per submesh per
+    // model; needs an OpenGL 4.3 context
+    if (!settings.bakeStaticBatches && IndirectBatch::IsSupported())
+      ImGui::Checkbox("Multi-Draw Indirect", &settings.multiDrawIndirect);
   }
 
   // Asset Management
@@ -519,6 +537,17 @@ void BlockUI::DisplayBlockConstraints() {
 
     ImGui::SliderFloat("Default Weight", &settings.defaultWeight, 0.0f, 1.0f);
 
+    // Contradictions undo up to this many recent decisions; 0 disables
+    ImGui::SliderInt("Backtrack Depth", &settings.backtrackDepth, 0, 256);
+    ImGui::DragInt("Backtrack Budget", &settings.maxBacktracks, 10.0f, 0,
+                   100000);
+    // Wider grids are split into chunks solved on all cores; 0 disables
+    ImGui::SliderInt("Chunk Size", &settings.chunkSize, 0, 256);
+    // Races this many seeds; the first to meet every constraint wins
+    ImGui::SliderInt("Portfolio Solves", &settings.portfolioSize, 1, 16);
+    ImGui::DragInt("Portfolio Deadline (ms)", &settings.portfolioDeadlineMs,
+                   100.0f, 0, 600000);
+
     ImGui::Separator();
 
     // Show total cells for reference
@@ -1,4 +1,5 @@
 #include <GenWorld/Utils/Exporter/MeshExporter.h>
+#include <GenWorld/Utils/Profiler.h>
 #include <GenWorld/Utils/Utils.h>
 #include <assimp/Exporter.hpp>
 #include <assimp/scene.h>
@@ -24,6 +25,7 @@ void OBJBlockExporter::ExportBlockMeshAsOBJWithDialog(
 
 void OBJBlockExporter::ExportBlockMeshAsOBJ(const BlockMesh &blockMesh,
                                             const std::string &filename) {
+  Utils::Profiler::Scope scope("Export OBJ");
   std::filesystem::path outPath(filename);
   std::string outputDir = outPath.parent_path().string();
 
@@ -103,59 +105,85 @@ OBJBlockExporter::CreateSceneFromBlockMesh(const BlockMesh &blockMesh,
     delete meshData;
   }
 
-  // Export instance meshes (blockInstances that use asset models)
-  const auto &instanceMap = blockMesh.getAssetInstances();
-  const auto &modelMap = blockMesh.getAssetModels();
-
-  int instanceIndex = 0;
-  for (const auto &[modelPath, transforms] : instanceMap) {
-    auto modelIt = modelMap.find(modelPath);
-    if (modelIt == modelMap.end())
+  // Baked blocks are already merged and transformed; write each batch as
+  // one mesh instead of every instance on its own
+  const auto &batches = blockMesh.getStaticBatches();
+  for (size_t i = 0; i < batches.size(); ++i) {
+    std::string batchName = "BlockBatch_" + std::to_string(i);
+    MeshData *batchData = ConvertMeshToMeshData(*batches[i], batchName);
+    if (!batchData || batchData->vertices.empty() ||
+        batchData->indices.empty()) {
+      delete batchData;
       continue;
+    }
+    aiMesh *batchMesh = ConvertMeshDataToAssimp(
+        batchData, scene, batches[i]->getTexturePath(), outputDir);
+    if (batchMesh)
+      AddChildNode(scene->mRootNode,
+                   CreateNodeWithMesh(scene, batchName, batchMesh));
+    delete batchData;
+  }
 
-    const auto &model = modelIt->second;
-    const auto &meshes = model->getMeshes();
-
-    for (const auto &transform : transforms) {
-      aiNode *groupNode = new aiNode();
-      groupNode->mName =
-          aiString("BlockGroup_" + std::to_string(instanceIndex));
-
-      for (size_t i = 0; i < meshes.size(); ++i) {
-        Mesh *subMesh = meshes[i];
-        if (!subMesh)
-          continue;
-
-        std::string meshName = "BlockInstance_" +
-                               std::to_string(instanceIndex) + "_Mesh_" +
-                               std::to_string(i);
-        MeshData *instanceData =
-            ConvertMeshToMeshDataWithTransform(*subMesh, meshName, transform);
-
-        //  Skip if no geometry
-        if (!instanceData || instanceData->vertices.empty() ||
-            instanceData->indices.empty()) {
-          std::cerr << " Skipping empty instance mesh: " << meshName
-                    << std::endl;
-          delete instanceData;
-          continue;
-        }
+  // Export instance meshes (blockInstances that use asset models), then
+  // the enclosed blocks the generator kept for export only
+  const auto &modelMap = blockMesh.getAssetModels();
+  std::vector<const std::map<std::string, std::vector<glm::mat4>> *>
+      instanceMaps;
+  if (batches.empty())
+    instanceMaps.push_back(&blockMesh.getAssetInstances());
+  instanceMaps.push_back(&blockMesh.getInteriorInstances());
 
-        std::string texture = subMesh->getTexturePath();
-        aiMesh *instanceMesh =
-            ConvertMeshDataToAssimp(instanceData, scene, texture, outputDir);
-        if (!instanceMesh) {
+  int instanceIndex = 0;
+  for (const auto *instanceMap : instanceMaps) {
+    for (const auto &[modelPath, transforms] : *instanceMap) {
+      auto modelIt = modelMap.find(modelPath);
+      if (modelIt == modelMap.end())
+        continue;
+
+      const auto &model = modelIt->second;
+      const auto &meshes = model->getMeshes();
+
+      for (const auto &transform : transforms) {
+        aiNode *groupNode = new aiNode();
+        groupNode->mName =
+            aiString("BlockGroup_" + std::to_string(instanceIndex));
+
+        for (size_t i = 0; i < meshes.size(); ++i) {
+          Mesh *subMesh = meshes[i];
+          if (!subMesh)
+            continue;
+
+          std::string meshName = "BlockInstance_" +
+                                 std::to_string(instanceIndex) + "_Mesh_" +
+                                 std::to_string(i);
+          MeshData *instanceData =
+              ConvertMeshToMeshDataWithTransform(*subMesh, meshName, transform);
+
+          //  Skip if no geometry
+          if (!instanceData || instanceData->vertices.empty() ||
+              instanceData->indices.empty()) {
+            std::cerr << " Skipping empty instance mesh: " << meshName
+                      << std::endl;
+            delete instanceData;
+            continue;
+          }
+
+          std::string texture = subMesh->getTexturePath();
+          aiMesh *instanceMesh =
+              ConvertMeshDataToAssimp(instanceData, scene, texture, outputDir);
+          if (!instanceMesh) {
+            delete instanceData;
+            continue;
+          }
+
+          aiNode *node = CreateNodeWithMesh(scene, meshName, instanceMesh);
+          AddChildNode(groupNode, node);
           delete instanceData;
-          continue;
         }
 
-        aiNode *node = CreateNodeWithMesh(scene, meshName, instanceMesh);
-        AddChildNode(groupNode, node);
-        delete instanceData;
+        AddChildNode(scene->mRootNode, groupNode);
+        ++instanceIndex;
       }
-
-      AddChildNode(scene->mRootNode, groupNode);
-      ++instanceIndex;
     }
   }
 
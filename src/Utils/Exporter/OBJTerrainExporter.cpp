@@ -1,5 +1,7 @@
+#include <GenWorld/Core/GLState.h>
 #include <GenWorld/Core/stb_image_write.h>
 #include <GenWorld/Utils/Exporter/MeshExporter.h>
+#include <GenWorld/Utils/Profiler.h>
 #include <GenWorld/Utils/Utils.h>
 #include <assimp/Exporter.hpp>
 #include <assimp/scene.h>
@@ -25,6 +27,7 @@ void OBJTerrainExporter::ExportTerrainAsOBJWithDialog(
 
 void OBJTerrainExporter::ExportTerrainAsOBJ(const TerrainMesh &terrain,
                                             const std::string &filename) {
+  Utils::Profiler::Scope scope("Export OBJ");
   std::filesystem::path outPath(filename);
   std::string outputDir = outPath.parent_path().string();
   std::string terrainTexturePath;
@@ -59,9 +62,9 @@ bool OBJTerrainExporter::ExportTerrainTextureFromGPU(
   const int texSize = 1024; // Could be made configurable
   std::vector<unsigned char> pixels(texSize * texSize * 3); // RGB
 
-  glBindTexture(GL_TEXTURE_2D, terrain.getTextureID());
+  GLState::BindTexture2D(terrain.getTextureID());
   glGetTexImage(GL_TEXTURE_2D, 0, GL_RGB, GL_UNSIGNED_BYTE, pixels.data());
-  glBindTexture(GL_TEXTURE_2D, 0);
+  GLState::BindTexture2D(0);
 
   if (!stbi_write_png(outputPath.c_str(), texSize, texSize, 3, pixels.data(),
                       texSize * 3)) {
@@ -0,0 +1,282 @@
+#include <GenWorld/Utils/MeshSimplifier.h>
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <cstring>
+#include <queue>
+#include <unordered_map>
+
+namespace {
+// Open borders weigh this much more than surface planes, so an outline
+// only moves once the inside has nothing cheaper left
+constexpr double kBorderWeight = 10.0;
+
+// Sum of squared distances to a set of planes, as the upper triangle of a
+// symmetric 4x4 matrix
+struct Quadric {
+  double a[10] = {};
+
+  void AddPlane(const glm::vec3 &normal, float d, double weight) {
+    double p[4] = {normal.x, normal.y, normal.z, d};
+    int k = 0;
+    for (int i = 0; i < 4; ++i)
+      for (int j = i; j < 4; ++j)
+        a[k++] += weight * p[i] * p[j];
+  }
+  void Add(const Quadric &other) {
+    for (int i = 0; i < 10; ++i)
+      a[i] += other.a[i];
+  }
+  double Error(const glm::vec3 &v) const {
+    double x = v.x, y = v.y, z = v.z;
+    return a[0] * x * x + 2 * a[1] * x * y + 2 * a[2] * x * z + 2 * a[3] * x +
+           a[4] * y * y + 2 * a[5] * y * z + 2 * a[6] * y + a[7] * z * z +
+           2 * a[8] * z + a[9];
+  }
+};
+
+struct PositionHash {
+  size_t operator()(const glm::vec3 &p) const {
+    uint32_t bits[3];
+    std::memcpy(bits, &p.x, sizeof(float));
+    std::memcpy(bits + 1, &p.y, sizeof(float));
+    std::memcpy(bits + 2, &p.z, sizeof(float));
+    return (bits[0] * 73856093u) ^ (bits[1] * 19349663u) ^
+           (bits[2] * 83492791u);
+  }
+};
+struct PositionEqual {
+  bool operator()(const glm::vec3 &a, const glm::vec3 &b) const {
+    return a.x == b.x && a.y == b.y && a.z == b.z;
+  }
+};
+
+// Collapsing `from` onto `to`, with the cost of doing so
+struct Collapse {
+  double cost;
+  uint32_t from, to;
+  uint32_t fromVersion, toVersion;
+  bool operator>(const Collapse &other) const { return cost > other.cost; }
+};
+} // namespace
+
+std::vector<unsigned int>
+MeshSimplifier::Simplify(const std::vector<Vertex> &vertices,
+                         const std::vector<unsigned int> &indices,
+                         size_t targetIndexCount, float maxError) {
+  size_t triangleCount = indices.size() / 3;
+  if (indices.size() <= targetIndexCount || triangleCount == 0)
+    return indices;
+
+  // Every vertex belongs to the position it shares with its seam twins;
+  // collapses move positions, and triangles follow their corners' positions
+  std::unordered_map<glm::vec3, uint32_t, PositionHash, PositionEqual> ids;
+  std::vector<uint32_t> positionOf(vertices.size());
+  std::vector<glm::vec3> positions;
+  std::vector<uint32_t> anyVertex; // [position] a vertex that has it
+  for (uint32_t v = 0; v < vertices.size(); ++v) {
+    auto [it, added] = ids.emplace(vertices[v].Position,
+                                   static_cast<uint32_t>(positions.size()));
+    if (added) {
+      positions.push_back(vertices[v].Position);
+      anyVertex.push_back(v);
+    }
+    positionOf[v] = it->second;
+  }
+  size_t positionCount = positions.size();
+
+  std::vector<std::array<uint32_t, 3>> triangles(triangleCount);
+  std::vector<uint8_t> alive(triangleCount, 1);
+  std::vector<std::vector<uint32_t>> trianglesAt(positionCount);
+  std::vector<Quadric> quadrics(positionCount);
+  size_t liveTriangles = 0;
+  auto corner = [&](uint32_t t, int k) { return positionOf[triangles[t][k]]; };
+
+  for (uint32_t t = 0; t < triangleCount; ++t) {
+    for (int k = 0; k < 3; ++k)
+      triangles[t][k] = indices[t * 3 + k];
+    uint32_t a = corner(t, 0), b = corner(t, 1), c = corner(t, 2);
+    if (a == b || b == c || a == c) {
+      alive[t] = 0;
+      continue;
+    }
+    ++liveTriangles;
+    glm::vec3 normal = glm::cross(positions[b] - positions[a],
+                                  positions[c] - positions[a]);
+    float area = glm::length(normal);
+    if (area > 0.0f) {
+      normal = normal * (1.0f / area);
+      for (uint32_t p : {a, b, c})
+        quadrics[p].AddPlane(normal, -glm::dot(normal, positions[a]),
+                             area * 0.5);
+    }
+    for (uint32_t p : {a, b, c})
+      trianglesAt[p].push_back(t);
+  }
+
+  // Edges with a single triangle are borders; a plane through the edge,
+  // upright to the triangle, keeps collapses from pulling them inwards
+  std::unordered_map<uint64_t, std::pair<uint32_t, int>> edges;
+  auto edgeKey = [](uint32_t a, uint32_t b) {
+    return (static_cast<uint64_t>(std::min(a, b)) << 32) | std::max(a, b);
+  };
+  for (uint32_t t = 0; t < triangleCount; ++t) {
+    if (!alive[t])
+      continue;
+    for (int k = 0; k < 3; ++k) {
+      auto &entry = edges[edgeKey(corner(t, k), corner(t, (k + 1) % 3))];
+      entry.first = t;
+      entry.second++;
+    }
+  }
+  for (const auto &[key, entry] : edges) {
+    if (entry.second != 1)
+      continue;
+    auto a = static_cast<uint32_t>(key >> 32);
+    auto b = static_cast<uint32_t>(key & 0xFFFFFFFFu);
+    uint32_t t = entry.first;
+    glm::vec3 faceNormal =
+        glm::cross(positions[corner(t, 1)] - positions[corner(t, 0)],
+                   positions[corner(t, 2)] - positions[corner(t, 0)]);
+    glm::vec3 edge = positions[b] - positions[a];
+    glm::vec3 normal = glm::cross(edge, faceNormal);
+    float length = glm::length(normal);
+    if (length <= 0.0f)
+      continue;
+    normal = normal * (1.0f / length);
+    double weight = kBorderWeight * glm::dot(edge, edge);
+    for (uint32_t p : {a, b})
+      quadrics[p].AddPlane(normal, -glm::dot(normal, positions[a]), weight);
+  }
+
+  std::vector<uint8_t> removed(positionCount, 0);
+  std::vector<uint32_t> version(positionCount, 0);
+  std::priority_queue<Collapse, std::vector<Collapse>, std::greater<Collapse>>
+      queue;
+  auto push = [&](uint32_t from, uint32_t to) {
+    Quadric sum = quadrics[from];
+    sum.Add(quadrics[to]);
+    queue.push({sum.Error(positions[to]), from, to, version[from],
+                version[to]});
+  };
+  auto pushAround = [&](uint32_t p) {
+    for (uint32_t t : trianglesAt[p])
+      for (int k = 0; k < 3; ++k) {
+        uint32_t other = corner(t, k);
+        if (other != p) {
+          push(p, other);
+          push(other, p);
+        }
+      }
+  };
+  for (uint32_t p = 0; p < positionCount; ++p)
+    pushAround(p);
+
+  // Moving `from` onto `to` must not turn any remaining triangle over
+  auto flips = [&](uint32_t from, uint32_t to) {
+    for (uint32_t t : trianglesAt[from]) {
+      if (!alive[t])
+        continue;
+      uint32_t p[3] = {corner(t, 0), corner(t, 1), corner(t, 2)};
+      if (p[0] == to || p[1] == to || p[2] == to)
+        continue;
+      glm::vec3 before = glm::cross(positions[p[1]] - positions[p[0]],
+                                    positions[p[2]] - positions[p[0]]);
+      for (uint32_t &q : p)
+        if (q == from)
+          q = to;
+      glm::vec3 after = glm::cross(positions[p[1]] - positions[p[0]],
+                                   positions[p[2]] - positions[p[0]]);
+      if (glm::dot(before, after) <= 0.0f)
+        return true;
+    }
+    return false;
+  };
+
+  double maxCost = static_cast<double>(maxError) * maxError;
+  size_t targetTriangles = targetIndexCount / 3;
+  std::unordered_map<uint32_t, uint32_t> vertexMap;
+  while (!queue.empty() && liveTriangles > targetTriangles) {
+    Collapse collapse = queue.top();
+    queue.pop();
+    uint32_t from = collapse.from, to = collapse.to;
+    if (removed[from] || removed[to] || version[from] != collapse.fromVersion ||
+        version[to] != collapse.toVersion)
+      continue;
+    if (collapse.cost > maxCost)
+      break;
+    if (flips(from, to))
+      continue;
+
+    // Each corner at `from` moves to the vertex across the collapsed edge
+    // it shares a triangle with, so seams keep their attributes where they
+    // can; corners with no such edge take any vertex at `to`
+    vertexMap.clear();
+    for (uint32_t t : trianglesAt[from]) {
+      if (!alive[t])
+        continue;
+      int f = -1, g = -1;
+      for (int k = 0; k < 3; ++k) {
+        if (corner(t, k) == from)
+          f = k;
+        else if (corner(t, k) == to)
+          g = k;
+      }
+      if (f >= 0 && g >= 0)
+        vertexMap.emplace(triangles[t][f], triangles[t][g]);
+    }
+
+    std::vector<uint32_t> &moved = trianglesAt[to];
+    for (uint32_t t : trianglesAt[from]) {
+      if (!alive[t])
+        continue;
+      bool touchesTo = false;
+      for (int k = 0; k < 3; ++k)
+        touchesTo |= corner(t, k) == to;
+      if (touchesTo) {
+        alive[t] = 0;
+        --liveTriangles;
+        continue;
+      }
+      for (int k = 0; k < 3; ++k) {
+        if (corner(t, k) != from)
+          continue;
+        auto it = vertexMap.find(triangles[t][k]);
+        triangles[t][k] = it != vertexMap.end() ? it->second : anyVertex[to];
+      }
+      moved.push_back(t);
+    }
+    moved.erase(std::remove_if(moved.begin(), moved.end(),
+                               [&](uint32_t t) { return !alive[t]; }),
+                moved.end());
+    trianglesAt[from].clear();
+    trianglesAt[from].shrink_to_fit();
+
+    quadrics[to].Add(quadrics[from]);
+    removed[from] = 1;
+    ++version[to];
+    pushAround(to);
+  }
+
+  std::vector<unsigned int> result;
+  result.reserve(liveTriangles * 3);
+  for (uint32_t t = 0; t < triangleCount; ++t)
+    if (alive[t])
+      result.insert(result.end(), triangles[t].begin(), triangles[t].end());
+  return result;
+}
+
+std::vector<Vertex>
+MeshSimplifier::Compact(const std::vector<Vertex> &vertices,
+                        std::vector<unsigned int> &indices) {
+  std::vector<unsigned int> remap(vertices.size(), ~0u);
+  std::vector<Vertex> used;
+  for (unsigned int &index : indices) {
+    if (remap[index] == ~0u) {
+      remap[index] = static_cast<unsigned int>(used.size());
+      used.push_back(vertices[index]);
+    }
+    index = remap[index];
+  }
+  return used;
+}
@@ -0,0 +1,278 @@
+#include <GenWorld/Utils/OpenGlInc.h>
+#include <GenWorld/Utils/Profiler.h>
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <deque>
+#include <map>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include <imgui.h>
+
+namespace Utils {
+namespace {
+constexpr int kGpuThread = 0;
+// GPU scopes in flight at once; more are dropped until some finish
+constexpr size_t kMaxPendingGpu = 512;
+
+struct TraceEvent {
+  const char *name;
+  int thread;
+  double start, duration; // microseconds
+};
+
+struct Stats {
+  float samples[Profiler::kHistory]; // milliseconds, a ring
+  int count = 0, next = 0;
+  int depth = 0;
+  const char *name = nullptr;
+};
+
+struct PendingGpu {
+  const char *name;
+  std::string path;
+  int depth;
+  unsigned int begin, end = 0;
+};
+
+// Everything below is shared between threads under `lock`, except the GPU
+// queue, which only the GL thread touches
+std::mutex lock;
+// Keyed by the path of scope names from the root, so that sorting by key
+// puts each scope right after its parent
+std::map<std::string, Stats> stats;
+std::vector<TraceEvent> trace;
+size_t traceNext = 0;
+std::map<std::thread::id, int> threadIds;
+
+std::deque<PendingGpu> pendingGpu;
+long long firstPendingId = 0;
+std::vector<unsigned int> freeQueries;
+std::vector<const char *> gpuStack;
+
+thread_local std::vector<const char *> scopeStack;
+thread_local int threadId = -1;
+
+double now() {
+  static const auto start = std::chrono::steady_clock::now();
+  return std::chrono::duration<double, std::micro>(
+             std::chrono::steady_clock::now() - start)
+      .count();
+}
+
+std::string pathOf(const std::vector<const char *> &stack, const char *name,
+                   const char *root) {
+  std::string path = root;
+  for (const char *parent : stack)
+    path.append("/").append(parent);
+  return path.append("/").append(name);
+}
+
+// Caller holds `lock`.
+void record(const char *name, const std::string &path, int depth,
+            int thread, double start, double duration) {
+  Stats &entry = stats[path];
+  entry.name = name;
+  entry.depth = depth;
+  entry.samples[entry.next] = static_cast<float>(duration * 1e-3);
+  entry.next = (entry.next + 1) % Profiler::kHistory;
+  entry.count = std::min(entry.count + 1, Profiler::kHistory);
+
+  if (trace.size() < Profiler::kTraceCapacity)
+    trace.push_back({name, thread, start, duration});
+  else
+    trace[traceNext] = {name, thread, start, duration};
+  traceNext = (traceNext + 1) % Profiler::kTraceCapacity;
+}
+
+// Caller holds `lock`.
+int currentThread() {
+  if (threadId < 0) {
+    auto inserted = threadIds.emplace(std::this_thread::get_id(),
+                                      static_cast<int>(threadIds.size()) + 1);
+    threadId = inserted.first->second;
+  }
+  return threadId;
+}
+
+float percentile(std::vector<float> &values, float fraction) {
+  size_t index = static_cast<size_t>(fraction * (values.size() - 1) + 0.5f);
+  std::nth_element(values.begin(), values.begin() + index, values.end());
+  return values[index];
+}
+
+void writeEscaped(FILE *file, const char *text) {
+  for (; *text; ++text) {
+    if (*text == '"' || *text == '\\')
+      std::fputc('\\', file);
+    std::fputc(*text, file);
+  }
+}
+} // namespace
+
+Profiler::Scope::Scope(const char *name) : name(name), start(now()) {
+  scopeStack.push_back(name);
+}
+
+Profiler::Scope::~Scope() {
+  double end = now();
+  scopeStack.pop_back();
+  std::string path = pathOf(scopeStack, name, "CPU");
+  std::lock_guard<std::mutex> guard(lock);
+  record(name, path, static_cast<int>(scopeStack.size()), currentThread(),
+         start, end - start);
+}
+
+Profiler::GpuScope::GpuScope(const char *name) {
+  if (pendingGpu.size() >= kMaxPendingGpu)
+    return;
+  PendingGpu pending{name, pathOf(gpuStack, name, "GPU"),
+                     static_cast<int>(gpuStack.size()), 0};
+  if (freeQueries.empty()) {
+    unsigned int queries[2];
+    glGenQueries(2, queries);
+    freeQueries.insert(freeQueries.end(), queries, queries + 2);
+  }
+  pending.begin = freeQueries.back();
+  freeQueries.pop_back();
+  glQueryCounter(pending.begin, GL_TIMESTAMP);
+
+  id = firstPendingId + static_cast<long long>(pendingGpu.size());
+  pendingGpu.push_back(std::move(pending));
+  gpuStack.push_back(name);
+}
+
+Profiler::GpuScope::~GpuScope() {
+  if (id < 0)
+    return;
+  gpuStack.pop_back();
+  if (freeQueries.empty()) {
+    unsigned int query;
+    glGenQueries(1, &query);
+    freeQueries.push_back(query);
+  }
+  PendingGpu &pending = pendingGpu[id - firstPendingId];
+  pending.end = freeQueries.back();
+  freeQueries.pop_back();
+  glQueryCounter(pending.end, GL_TIMESTAMP);
+}
+
+void Profiler::NewFrame() {
+  if (pendingGpu.empty())
+    return;
+
+  // GPU timestamps run on their own clock; matching it against ours once a
+  // frame places GPU work on the CPU timeline of the trace
+  GLint64 gpuNow = 0;
+  glGetInteger64v(GL_TIMESTAMP, &gpuNow);
+  double offset = now() - static_cast<double>(gpuNow) * 1e-3;
+
+  std::lock_guard<std::mutex> guard(lock);
+  // Queries complete in the order they were issued
+  while (!pendingGpu.empty()) {
+    PendingGpu &pending = pendingGpu.front();
+    if (pending.end == 0)
+      break;
+    GLint available = 0;
+    glGetQueryObjectiv(pending.end, GL_QUERY_RESULT_AVAILABLE, &available);
+    if (!available)
+      break;
+    GLuint64 begin = 0, end = 0;
+    glGetQueryObjectui64v(pending.begin, GL_QUERY_RESULT, &begin);
+    glGetQueryObjectui64v(pending.end, GL_QUERY_RESULT, &end);
+    record(pending.name, pending.path, pending.depth, kGpuThread,
+           static_cast<double>(begin) * 1e-3 + offset,
+           static_cast<double>(end - begin) * 1e-3);
+    freeQueries.push_back(pending.begin);
+    freeQueries.push_back(pending.end);
+    pendingGpu.pop_front();
+    ++firstPendingId;
+  }
+}
+
+void Profiler::DrawWindow(bool *open) {
+  if (!ImGui::Begin("Profiler", open)) {
+    ImGui::End();
+    return;
+  }
+  if (ImGui::Button("Clear"))
+    Clear();
+  ImGui::SameLine();
+  ImGui::TextDisabled("milliseconds over the last %d samples", kHistory);
+
+  const ImGuiTableFlags flags = ImGuiTableFlags_RowBg |
+                                ImGuiTableFlags_BordersInnerV |
+                                ImGuiTableFlags_ScrollY;
+  if (ImGui::BeginTable("ProfilerScopes", 6, flags)) {
+    ImGui::TableSetupScrollFreeze(0, 1);
+    ImGui::TableSetupColumn("Scope", ImGuiTableColumnFlags_WidthStretch);
+    for (const char *column : {"Last", "P50", "P95", "P99", "Max"})
+      ImGui::TableSetupColumn(column, ImGuiTableColumnFlags_WidthFixed);
+    ImGui::TableHeadersRow();
+
+    std::lock_guard<std::mutex> guard(lock);
+    std::vector<float> values;
+    std::string section;
+    for (const auto &[path, entry] : stats) {
+      // CPU and GPU scopes each get a heading row
+      std::string root = path.substr(0, path.find('/'));
+      if (root != section) {
+        section = root;
+        ImGui::TableNextRow();
+        ImGui::TableNextColumn();
+        ImGui::TextDisabled("%s", section.c_str());
+      }
+
+      values.assign(entry.samples, entry.samples + entry.count);
+      float last = entry.samples[(entry.next + kHistory - 1) % kHistory];
+      ImGui::TableNextRow();
+      ImGui::TableNextColumn();
+      ImGui::Indent(ImGui::GetStyle().IndentSpacing * (entry.depth + 1));
+      ImGui::TextUnformatted(entry.name);
+      ImGui::Unindent(ImGui::GetStyle().IndentSpacing * (entry.depth + 1));
+      ImGui::TableNextColumn();
+      ImGui::Text("%.2f", last);
+      for (float fraction : {0.5f, 0.95f, 0.99f, 1.0f}) {
+        ImGui::TableNextColumn();
+        ImGui::Text("%.2f", percentile(values, fraction));
+      }
+    }
+    ImGui::EndTable();
+  }
+  ImGui::End();
+}
+
+bool Profiler::ExportTrace(const std::string &path) {
+  FILE *file = std::fopen(path.c_str(), "w");
+  if (!file)
+    return false;
+
+  std::lock_guard<std::mutex> guard(lock);
+  std::fprintf(file, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+  std::fprintf(file, "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,"
+                     "\"tid\":%d,\"args\":{\"name\":\"GPU\"}}",
+               kGpuThread);
+  // Oldest first once the ring has wrapped
+  size_t first = trace.size() < kTraceCapacity ? 0 : traceNext;
+  for (size_t i = 0; i < trace.size(); ++i) {
+    const TraceEvent &event = trace[(first + i) % trace.size()];
+    std::fprintf(file, ",\n{\"name\":\"");
+    writeEscaped(file, event.name);
+    std::fprintf(file,
+                 "\",\"cat\":\"%s\",\"ph\":\"X\",\"pid\":1,\"tid\":%d,"
+                 "\"ts\":%.3f,\"dur\":%.3f}",
+                 event.thread == kGpuThread ? "gpu" : "cpu", event.thread,
+                 event.start, event.duration);
+  }
+  std::fprintf(file, "\n]}\n");
+  return std::fclose(file) == 0;
+}
+
+void Profiler::Clear() {
+  std::lock_guard<std::mutex> guard(lock);
+  stats.clear();
+  trace.clear();
+  traceNext = 0;
+}
+} // namespace Utils